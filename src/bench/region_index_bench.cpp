@@ -0,0 +1,81 @@
+// Random-address lookup latency of MemoryRegionIndex against dump region count.
+// Prints one CSV row per region count, the linear scan column is the lookup
+// strategy the index replaced.
+#include "Minidump/MemoryRegionIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kRegionSize = 0x3000;
+constexpr uint64_t kRegionStride = 0x10000;
+constexpr size_t kLookups = 1000000;
+
+const uint8_t* LinearFind(const std::vector<MinidumpContext::MemoryRegion>& regions, uint64_t address) {
+    for (const auto& region : regions) {
+        if (address >= region.base && address < region.base + region.size) {
+            return region.data + (address - region.base);
+        }
+    }
+    return nullptr;
+}
+
+template <typename Fn>
+double MeasureNsPerLookup(const std::vector<uint64_t>& addresses, size_t lookups, Fn&& fn) {
+    uintptr_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        sink += reinterpret_cast<uintptr_t>(fn(addresses[i % addresses.size()]));
+    }
+    const auto end = std::chrono::steady_clock::now();
+    // Keep the compiler from dropping the lookups
+    if (sink == 1) {
+        std::puts("");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t max_regions = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 65536;
+    std::vector<uint8_t> backing(kRegionSize);
+    std::mt19937_64 rng(0x5eed);
+
+    std::printf("regions,lookups,index_ns,linear_ns\n");
+    for (size_t count = 16; count <= max_regions; count *= 4) {
+        std::vector<MinidumpContext::MemoryRegion> regions;
+        regions.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            regions.push_back({0x10000000 + i * kRegionStride, kRegionSize, backing.data(), 0x04});
+        }
+
+        MinidumpContext::MemoryRegionIndex index;
+        index.Build(regions);
+
+        // Mix of hits and misses that land in the gaps between regions
+        std::vector<uint64_t> addresses(4096);
+        std::uniform_int_distribution<uint64_t> dist(0x10000000, 0x10000000 + count * kRegionStride);
+        for (auto& address : addresses) {
+            address = dist(rng);
+        }
+
+        const double index_ns = MeasureNsPerLookup(addresses, kLookups, [&](uint64_t address) {
+            return index.View(address, 1).data();
+        });
+
+        // The linear scan gets fewer iterations on large tables to keep the run short
+        const size_t linear_lookups = std::max<size_t>(kLookups / count, 1000);
+        const double linear_ns = MeasureNsPerLookup(addresses, linear_lookups, [&](uint64_t address) {
+            return LinearFind(regions, address);
+        });
+
+        std::printf("%zu,%zu,%.2f,%.2f\n", count, kLookups, index_ns, linear_ns);
+    }
+    return 0;
+}
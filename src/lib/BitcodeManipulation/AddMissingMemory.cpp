@@ -1,16 +1,45 @@
 #include "AddMissingMemory.h"
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
 #include <glog/logging.h>
 
 namespace BitcodeManipulation {
 
-bool AddMissingMemory(llvm::Module &M, uint64_t addr, const std::vector<uint8_t>& page) {
+static bool AddConstMemoryPage(llvm::Module &M, uint64_t addr, llvm::Constant* pageArray) {
+    std::string name;
+    llvm::raw_string_ostream rso(name);
+    rso << kConstMemoryPagePrefix << llvm::format_hex_no_prefix(addr, 1);
+    rso.flush();
+
+    if (M.getGlobalVariable(name, true)) {
+        VLOG(1) << "Constant memory page already exists: " << name;
+        return true;
+    }
+
+    new llvm::GlobalVariable(
+        M,
+        pageArray->getType(),
+        true, // isConstant
+        llvm::GlobalValue::InternalLinkage,
+        pageArray,
+        name
+    );
+
+    VLOG(1) << "Added constant memory page for address 0x" << std::hex << addr;
+    return true;
+}
+
+bool AddMissingMemory(llvm::Module &M, uint64_t addr, llvm::ArrayRef<uint8_t> page, bool immutable) {
     if (page.size() != PREBUILT_MEMORY_CELL_SIZE) {
         LOG(ERROR) << "Page size is not " << PREBUILT_MEMORY_CELL_SIZE;
         return false;
     }
+    return AddMemoryPages(M, {{addr, llvm::ConstantDataArray::get(M.getContext(), page), immutable}});
+}
 
+bool AddMemoryPages(llvm::Module &M, llvm::ArrayRef<MemoryPage> pages) {
     // Find the GlobalMemoryCells64 global variable
     auto* globalCells = M.getGlobalVariable("GlobalMemoryCells64");
     if (!globalCells) {
@@ -20,37 +49,10 @@ bool AddMissingMemory(llvm::Module &M, uint64_t addr, const std::vector<uint8_t>
 
     auto& context = M.getContext();
 
-    // Create array for the page data
-    std::vector<llvm::Constant*> pageValues;
-    for (size_t i = 0; i < page.size() && i < PREBUILT_MEMORY_CELL_SIZE; i++) {
-        pageValues.push_back(llvm::ConstantInt::get(llvm::Type::getInt8Ty(context), page[i]));
-    }
-    
-    // Pad with zeros if needed
-    while (pageValues.size() < PREBUILT_MEMORY_CELL_SIZE) {
-        pageValues.push_back(llvm::ConstantInt::get(llvm::Type::getInt8Ty(context), 0));
-    }
-
-    // Create the page data array
-    auto* pageArray = llvm::ConstantArray::get(
-        llvm::ArrayType::get(llvm::Type::getInt8Ty(context), PREBUILT_MEMORY_CELL_SIZE),
-        pageValues
-    );
-
     // Get the struct type from the global variable's type
     auto* arrayType = llvm::cast<llvm::ArrayType>(globalCells->getValueType());
     auto* structTy = llvm::cast<llvm::StructType>(arrayType->getElementType());
 
-    // Create the new cell struct elements
-    std::vector<llvm::Constant*> cellElements = {
-        llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), addr), // addr
-        pageArray // val array
-    };
-    
-    // Create the new cell
-    auto* newCell = llvm::ConstantStruct::get(structTy, cellElements);
-
-    // Create new array with just our new element
     std::vector<llvm::Constant*> newElements;
     
     // If there's an existing initializer that's not zeroinitializer, add its elements
@@ -59,28 +61,38 @@ bool AddMissingMemory(llvm::Module &M, uint64_t addr, const std::vector<uint8_t>
             newElements.push_back(currentInit->getOperand(i));
         }
     }
-    
-    // Add our new cell
-    newElements.push_back(newCell);
+
+    // Immutable pages get constant globals of their own, the rest become cells
+    size_t constPages = 0;
+    for (const auto& page : pages) {
+        if (page.immutable) {
+            AddConstMemoryPage(M, page.addr, page.data);
+            constPages++;
+            continue;
+        }
+        std::vector<llvm::Constant*> cellElements = {
+            llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), page.addr), // addr
+            page.data // val array
+        };
+        newElements.push_back(llvm::ConstantStruct::get(structTy, cellElements));
+    }
+    if (constPages == pages.size()) {
+        return true;
+    }
 
     // First create a new global variable with the right size
+    auto* newArrayTy = llvm::ArrayType::get(structTy, newElements.size());
     auto* newGlobal = new llvm::GlobalVariable(
         M,
-        llvm::ArrayType::get(structTy, newElements.size()),
+        newArrayTy,
         false, // isConstant
         llvm::GlobalValue::ExternalLinkage,
         nullptr,
         "GlobalMemoryCells64_new"
     );
 
-    // Create new array type and initializer
-    auto* newArray = llvm::ConstantArray::get(
-        llvm::ArrayType::get(structTy, newElements.size()),
-        newElements
-    );
-
     // Set the initializer on the new global
-    newGlobal->setInitializer(newArray);
+    newGlobal->setInitializer(llvm::ConstantArray::get(newArrayTy, newElements));
 
     // Replace all uses of the old global with the new one
     globalCells->replaceAllUsesWith(newGlobal);
@@ -91,9 +103,9 @@ bool AddMissingMemory(llvm::Module &M, uint64_t addr, const std::vector<uint8_t>
     // Remove the old global
     globalCells->eraseFromParent();
 
-    LOG(INFO) << "Added memory cell for address 0x" << std::hex << addr 
-              << " with " << std::dec << page.size() << " bytes";
+    LOG(INFO) << "Added " << std::dec << pages.size() - constPages << " memory cells and "
+              << constPages << " constant pages";
               
     return true;
 }
-} 
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,12 +1,31 @@
 #pragma once
 
 #include <llvm/IR/Module.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/IR/Constant.h>
 #include <vector>
 #include <cstdint>
 #include "../Prebuilt/Utils.h"
 
 namespace BitcodeManipulation {
 
-bool AddMissingMemory(llvm::Module &M, uint64_t addr, const std::vector<uint8_t>& page);
+// Name prefix of the constant globals holding immutable pages
+constexpr const char* kConstMemoryPagePrefix = "ConstMemoryPage_";
+
+// Add a page to GlobalMemoryCells64. Immutable pages (read-only image memory)
+// get their own constant global instead, so reads from them can be folded.
+bool AddMissingMemory(llvm::Module &M, uint64_t addr, llvm::ArrayRef<uint8_t> page, bool immutable = false);
+
+// Page data already turned into a constant of the module's context. Constants
+// live as long as the context, so a page is materialized once and added to
+// the module of every later iteration without copying its bytes again.
+struct MemoryPage {
+    uint64_t addr;
+    llvm::Constant* data;
+    bool immutable;
+};
+
+// Add all pages at once, GlobalMemoryCells64 is rebuilt a single time
+bool AddMemoryPages(llvm::Module &M, llvm::ArrayRef<MemoryPage> pages);
 
 } // namespace BitcodeManipulation 
\ No newline at end of file
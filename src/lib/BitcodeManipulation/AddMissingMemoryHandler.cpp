@@ -1,4 +1,5 @@
 #include "AddMissingMemory.h"
+#include <cstring>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Constants.h>
 #include <glog/logging.h>
@@ -6,7 +7,8 @@
 
 namespace BitcodeManipulation {
 
-llvm::Function* CreateGetSavedMemoryPtr(llvm::Module &M) {
+llvm::Function* CreateGetSavedMemoryPtr(llvm::Module &M, bool track_access,
+                                        llvm::ArrayRef<std::pair<uint64_t, uint64_t>> fault_ranges) {
     auto& context = M.getContext();
 
     // Find the GlobalMemoryCells64 global variable
@@ -60,7 +62,91 @@ llvm::Function* CreateGetSavedMemoryPtr(llvm::Module &M) {
     // Initialize loop counter
     auto counter = builder.CreateAlloca(int64Ty);
     builder.CreateStore(llvm::ConstantInt::get(int64Ty, 0), counter);
-    builder.CreateBr(loopBB);
+
+    // Immutable pages live in their own constant globals, dispatch on the page
+    // address first so lookups with a known address fold to the constant
+    std::vector<std::pair<uint64_t, llvm::GlobalVariable*>> constPages;
+    for (auto& GV : M.globals()) {
+        uint64_t pageAddr = 0;
+        if (GV.getName().startswith(kConstMemoryPagePrefix) &&
+            !GV.getName().drop_front(strlen(kConstMemoryPagePrefix)).getAsInteger(16, pageAddr)) {
+            constPages.emplace_back(pageAddr, &GV);
+        }
+    }
+
+    // One slot per regular cell. Constant pages are not tracked, a store on
+    // their path would keep reads from them from folding to constants
+    llvm::GlobalVariable* accessedGlobal = nullptr;
+    llvm::ArrayType* accessedTy = nullptr;
+    if (track_access) {
+        if (auto* existing = M.getGlobalVariable("GlobalMemoryCellsAccessed")) {
+            existing->eraseFromParent();
+        }
+        accessedTy = llvm::ArrayType::get(int64Ty, numElements);
+        accessedGlobal = new llvm::GlobalVariable(
+            M,
+            accessedTy,
+            false, // isConstant
+            llvm::GlobalValue::ExternalLinkage,
+            llvm::ConstantAggregateZero::get(accessedTy),
+            "GlobalMemoryCellsAccessed"
+        );
+    }
+
+    // Ranges known to be unmapped share one block that reports the fault and
+    // hands out a zero page. They are checked by range, a gap between regions
+    // may span a large part of the address space
+    llvm::BasicBlock* lookupBB = loopBB;
+    if (!fault_ranges.empty()) {
+        auto pageTy = llvm::ArrayType::get(llvm::Type::getInt8Ty(context), PREBUILT_MEMORY_CELL_SIZE);
+        auto* faultPage = M.getGlobalVariable("FaultMemoryPage", true);
+        if (!faultPage) {
+            faultPage = new llvm::GlobalVariable(
+                M,
+                pageTy,
+                true, // isConstant
+                llvm::GlobalValue::InternalLinkage,
+                llvm::ConstantAggregateZero::get(pageTy),
+                "FaultMemoryPage"
+            );
+        }
+        auto faultFn = M.getOrInsertFunction("__rt_memory_fault",
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context), {int64Ty}, false));
+
+        auto faultBB = llvm::BasicBlock::Create(context, "return_fault", newFunc);
+        llvm::IRBuilder<> faultBuilder(faultBB);
+        faultBuilder.CreateCall(faultFn, {ptr});
+        faultBuilder.CreateRet(faultBuilder.CreatePtrToInt(faultPage, int64Ty));
+
+        // Built back to front, the last check falls through to the cell loop.
+        // ptr - start < end - start holds for ranges ending at the top of the
+        // address space as well
+        for (auto it = fault_ranges.rbegin(); it != fault_ranges.rend(); ++it) {
+            const auto [start, end] = *it;
+            auto checkFaultBB = llvm::BasicBlock::Create(context, "check_fault", newFunc, lookupBB);
+            llvm::IRBuilder<> checkBuilder(checkFaultBB);
+            auto offset = checkBuilder.CreateSub(ptr, llvm::ConstantInt::get(int64Ty, start));
+            auto inRange = checkBuilder.CreateICmpULT(offset, llvm::ConstantInt::get(int64Ty, end - start));
+            checkBuilder.CreateCondBr(inRange, faultBB, lookupBB);
+            lookupBB = checkFaultBB;
+        }
+        VLOG(1) << "Added " << fault_ranges.size() << " fault ranges to the lookup";
+    }
+
+    if (constPages.empty()) {
+        builder.CreateBr(lookupBB);
+    } else {
+        auto pageBase = builder.CreateAnd(ptr, 
+            llvm::ConstantInt::get(int64Ty, ~static_cast<uint64_t>(PREBUILT_MEMORY_CELL_SIZE - 1)));
+        auto constSwitch = builder.CreateSwitch(pageBase, lookupBB, constPages.size());
+        for (const auto& [pageAddr, pageGlobal] : constPages) {
+            auto constBB = llvm::BasicBlock::Create(context, "return_const", newFunc);
+            llvm::IRBuilder<> constBuilder(constBB);
+            constBuilder.CreateRet(constBuilder.CreatePtrToInt(pageGlobal, int64Ty));
+            constSwitch->addCase(llvm::ConstantInt::get(int64Ty, pageAddr), constBB);
+        }
+        VLOG(1) << "Added " << constPages.size() << " constant memory pages to the lookup";
+    }
 
     // Loop block
     builder.SetInsertPoint(loopBB);
@@ -101,6 +187,11 @@ llvm::Function* CreateGetSavedMemoryPtr(llvm::Module &M) {
 
     // Return found block
     builder.SetInsertPoint(returnFoundBB);
+    // Record the page for the read-ahead accounting
+    if (accessedGlobal) {
+        auto slot = builder.CreateGEP(accessedTy, accessedGlobal, {llvm::ConstantInt::get(int64Ty, 0), currentIdx});
+        builder.CreateStore(cellAddr, slot);
+    }
     // Get pointer to the data array field within the cell
     auto dataPtr = builder.CreateStructGEP(arrayType->getElementType(), cellPtr, 1);
     // Cast array pointer to integer
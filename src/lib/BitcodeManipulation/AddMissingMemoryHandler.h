@@ -1,12 +1,22 @@
 #pragma once
 
 #include <llvm/IR/Module.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <cstdint>
+#include <utility>
 
 namespace BitcodeManipulation {
 
 // Creates a function in the module that can look up saved memory cells
 // The function has signature: uintptr_t __rt_get_saved_memory_ptr(uintptr_t ptr)
 // Returns a pointer to the memory if found, 0 otherwise
-llvm::Function* CreateGetSavedMemoryPtr(llvm::Module &M);
+// With track_access the function also records every regular page it hands
+// out in the GlobalMemoryCellsAccessed array, one slot per cell. Constant
+// pages are left out so reads from them still fold.
+// Fault ranges [start, end) are known to be unmapped, reads from them call
+// __rt_memory_fault and are served from a shared zero page instead of being
+// reported missing
+llvm::Function* CreateGetSavedMemoryPtr(llvm::Module &M, bool track_access = false,
+                                        llvm::ArrayRef<std::pair<uint64_t, uint64_t>> fault_ranges = {});
 
 } // namespace BitcodeManipulation 
\ No newline at end of file
@@ -14,4 +14,6 @@
 #include "BitcodeManipulation/CreateEntryWithState.h"
 #include "BitcodeManipulation/ReplaceFunctions.h"
 #include "BitcodeManipulation/SetGlobalVariable.h"
-#include "BitcodeManipulation/ReplaceStackMemoryWrites.h"
\ No newline at end of file
+#include "BitcodeManipulation/ReplaceStackMemoryWrites.h"
+#include "BitcodeManipulation/ExtractFunctions.h"
+#include "BitcodeManipulation/StripUnreachable.h"
\ No newline at end of file
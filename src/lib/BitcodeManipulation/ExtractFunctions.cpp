@@ -0,0 +1,172 @@
+#include "BitcodeManipulation/ExtractFunctions.h"
+
+#include <glog/logging.h>
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+#include <vector>
+
+namespace BitcodeManipulation {
+
+namespace {
+
+// Globals used by a value, looking through constant expressions and aggregates
+void CollectGlobals(const llvm::Value* Value,
+                    std::vector<const llvm::GlobalValue*>& Worklist,
+                    llvm::SmallPtrSetImpl<const llvm::Constant*>& VisitedConstants) {
+    if (const auto* Global = llvm::dyn_cast<llvm::GlobalValue>(Value)) {
+        Worklist.push_back(Global);
+        return;
+    }
+    const auto* Constant = llvm::dyn_cast<llvm::Constant>(Value);
+    if (!Constant || !VisitedConstants.insert(Constant).second) {
+        return;
+    }
+    for (const auto& Operand : Constant->operands()) {
+        CollectGlobals(Operand.get(), Worklist, VisitedConstants);
+    }
+}
+
+} // anonymous namespace
+
+void CollectReachableGlobals(
+    llvm::ArrayRef<const llvm::GlobalValue*> Roots,
+    llvm::SmallPtrSetImpl<const llvm::GlobalValue*>& Reachable)
+{
+    llvm::SmallPtrSet<const llvm::Constant*, 32> VisitedConstants;
+    std::vector<const llvm::GlobalValue*> Worklist(Roots.begin(), Roots.end());
+    while (!Worklist.empty()) {
+        const auto* Global = Worklist.back();
+        Worklist.pop_back();
+        if (!Reachable.insert(Global).second) {
+            continue;
+        }
+        if (const auto* Function = llvm::dyn_cast<llvm::Function>(Global)) {
+            // Personality, prefix and prologue data are operands of the function itself
+            for (const auto& Operand : Function->operands()) {
+                CollectGlobals(Operand.get(), Worklist, VisitedConstants);
+            }
+            for (const auto& Inst : llvm::instructions(*Function)) {
+                for (const auto& Operand : Inst.operands()) {
+                    CollectGlobals(Operand.get(), Worklist, VisitedConstants);
+                }
+            }
+        } else if (const auto* Variable = llvm::dyn_cast<llvm::GlobalVariable>(Global)) {
+            if (Variable->hasInitializer()) {
+                CollectGlobals(Variable->getInitializer(), Worklist, VisitedConstants);
+            }
+        } else if (const auto* Alias = llvm::dyn_cast<llvm::GlobalAlias>(Global)) {
+            CollectGlobals(Alias->getAliasee(), Worklist, VisitedConstants);
+        }
+    }
+}
+
+std::unique_ptr<llvm::Module> ExtractFunctions(
+    const llvm::Module& SourceModule,
+    llvm::ArrayRef<llvm::Function*> Functions)
+{
+    // Everything the functions reach, transitively
+    llvm::SmallPtrSet<const llvm::GlobalValue*, 32> Reachable;
+    CollectReachableGlobals(std::vector<const llvm::GlobalValue*>(Functions.begin(), Functions.end()), Reachable);
+
+    auto Extracted = std::make_unique<llvm::Module>(SourceModule.getModuleIdentifier(), SourceModule.getContext());
+    Extracted->setSourceFileName(SourceModule.getSourceFileName());
+    Extracted->setDataLayout(SourceModule.getDataLayout());
+    Extracted->setTargetTriple(SourceModule.getTargetTriple());
+    Extracted->setModuleInlineAsm(SourceModule.getModuleInlineAsm());
+
+    // Create every reachable global first, bodies and initializers refer to
+    // each other. Walk the source in order so the copies keep its layout
+    llvm::ValueToValueMapTy Map;
+    const auto CopyComdat = [&Extracted](llvm::GlobalObject* Copy, const llvm::GlobalObject& Global) {
+        if (const auto* Comdat = Global.getComdat()) {
+            auto* CopiedComdat = Extracted->getOrInsertComdat(Comdat->getName());
+            CopiedComdat->setSelectionKind(Comdat->getSelectionKind());
+            Copy->setComdat(CopiedComdat);
+        }
+    };
+    for (const auto& Variable : SourceModule.globals()) {
+        if (!Reachable.count(&Variable)) {
+            continue;
+        }
+        auto* Copy = new llvm::GlobalVariable(
+            *Extracted, Variable.getValueType(), Variable.isConstant(), Variable.getLinkage(), nullptr,
+            Variable.getName(), nullptr, Variable.getThreadLocalMode(), Variable.getType()->getAddressSpace());
+        Copy->copyAttributesFrom(&Variable);
+        Map[&Variable] = Copy;
+    }
+    for (const auto& Function : SourceModule) {
+        if (!Reachable.count(&Function)) {
+            continue;
+        }
+        auto* Copy = llvm::Function::Create(Function.getFunctionType(), Function.getLinkage(),
+                                            Function.getAddressSpace(), Function.getName(), Extracted.get());
+        Copy->copyAttributesFrom(&Function);
+        Map[&Function] = Copy;
+    }
+    for (const auto& Alias : SourceModule.aliases()) {
+        if (!Reachable.count(&Alias)) {
+            continue;
+        }
+        auto* Copy = llvm::GlobalAlias::create(Alias.getValueType(), Alias.getType()->getPointerAddressSpace(),
+                                               Alias.getLinkage(), Alias.getName(), Extracted.get());
+        Copy->copyAttributesFrom(&Alias);
+        Map[&Alias] = Copy;
+    }
+
+    // Then their contents
+    for (const auto& Variable : SourceModule.globals()) {
+        if (!Reachable.count(&Variable)) {
+            continue;
+        }
+        auto* Copy = llvm::cast<llvm::GlobalVariable>(Map[&Variable]);
+        if (Variable.hasInitializer()) {
+            Copy->setInitializer(llvm::MapValue(Variable.getInitializer(), Map));
+        }
+        llvm::SmallVector<std::pair<unsigned, llvm::MDNode*>, 1> Metadata;
+        Variable.getAllMetadata(Metadata);
+        for (const auto& [Kind, Node] : Metadata) {
+            Copy->addMetadata(Kind, *llvm::MapMetadata(Node, Map));
+        }
+        CopyComdat(Copy, Variable);
+    }
+    for (const auto& Function : SourceModule) {
+        if (!Reachable.count(&Function)) {
+            continue;
+        }
+        auto* Copy = llvm::cast<llvm::Function>(Map[&Function]);
+        if (!Function.isDeclaration()) {
+            auto CopiedArg = Copy->arg_begin();
+            for (const auto& Arg : Function.args()) {
+                CopiedArg->setName(Arg.getName());
+                Map[&Arg] = &*CopiedArg++;
+            }
+            llvm::SmallVector<llvm::ReturnInst*, 8> Returns;
+            llvm::CloneFunctionInto(Copy, &Function, Map, llvm::CloneFunctionChangeType::ClonedModule, Returns);
+        }
+        CopyComdat(Copy, Function);
+    }
+    for (const auto& Alias : SourceModule.aliases()) {
+        if (Reachable.count(&Alias)) {
+            llvm::cast<llvm::GlobalAlias>(Map[&Alias])->setAliasee(llvm::MapValue(Alias.getAliasee(), Map));
+        }
+    }
+
+    // Module flags and other named metadata, references to globals that were
+    // not copied become null
+    for (const auto& Named : SourceModule.named_metadata()) {
+        auto* Copy = Extracted->getOrInsertNamedMetadata(Named.getName());
+        for (const auto* Operand : Named.operands()) {
+            Copy->addOperand(llvm::MapMetadata(Operand, Map, llvm::RF_NullMapMissingGlobalValues));
+        }
+    }
+
+    VLOG(1) << "Extracted " << Functions.size() << " functions with " << Reachable.size() - Functions.size()
+            << " dependencies, " << Extracted->size() << " functions in the new module";
+    return Extracted;
+}
+
+} // namespace BitcodeManipulation
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+
+namespace BitcodeManipulation {
+
+// Add the roots and every global they reach through calls, constant
+// references, initializers and aliasees to `Reachable`
+void CollectReachableGlobals(
+    llvm::ArrayRef<const llvm::GlobalValue*> Roots,
+    llvm::SmallPtrSetImpl<const llvm::GlobalValue*>& Reachable);
+
+// Copy the functions into a new module together with every global they reach
+// through calls and constant references. Nothing else of the source module
+// is copied, not even as a declaration, and the source is left unchanged.
+// The copies keep their names.
+std::unique_ptr<llvm::Module> ExtractFunctions(
+    const llvm::Module& SourceModule,
+    llvm::ArrayRef<llvm::Function*> Functions);
+
+} // namespace BitcodeManipulation
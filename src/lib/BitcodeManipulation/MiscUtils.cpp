@@ -14,27 +14,31 @@
 namespace BitcodeManipulation {
 
 // just as a sample
-void MergeModules(llvm::Module& M1, const llvm::Module& M2) {
+bool MergeModules(llvm::Module& M1, const llvm::Module& M2) {
 
     VLOG(1) << "Merging modules";
 
     VLOG(1) << "Verifying M2";
     if (llvm::verifyModule(M2, &llvm::errs())) {
         LOG(ERROR) << "M2 is not valid";
-        return;
+        return false;
     }
     VLOG(1) << "Verifying M1";    
     if (llvm::verifyModule(M1, &llvm::errs())) {
         LOG(ERROR) << "M1 is not valid";
-        return;
+        return false;
     }
     // Clone M2 to avoid modifying the original
     auto ClonedM2 = llvm::CloneModule(M2);
     VLOG(1) << "Cloned M2";
     
-    // Link the modules
-    llvm::Linker::linkModules(M1, std::move(ClonedM2));
+    // Link the modules, the linker reports what failed through the context
+    if (llvm::Linker::linkModules(M1, std::move(ClonedM2))) {
+        LOG(ERROR) << "Failed to link " << M2.getModuleIdentifier() << " into " << M1.getModuleIdentifier();
+        return false;
+    }
     VLOG(1) << "Linked modules";
+    return true;
 }
 
 void DumpModule(const llvm::Module& M, const std::string& filename) {
@@ -6,7 +6,9 @@
 
 namespace BitcodeManipulation {
 
-void MergeModules(llvm::Module& M1, const llvm::Module& M2);
+// Link a copy of M2 into M1. False if either module is invalid or linking
+// failed, e.g. on two definitions of one symbol; M1 is then left incomplete
+bool MergeModules(llvm::Module& M1, const llvm::Module& M2);
 void DumpModule(const llvm::Module& M, const std::string& filename);
 std::unique_ptr<llvm::Module> ReadBitcodeFile(const std::string& filename, llvm::LLVMContext& Context);
 
@@ -0,0 +1,77 @@
+#include "BitcodeManipulation/StripUnreachable.h"
+#include "BitcodeManipulation/ExtractFunctions.h"
+
+#include <glog/logging.h>
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/Constants.h>
+
+#include <unordered_set>
+
+namespace BitcodeManipulation {
+
+namespace {
+
+struct ModuleSize {
+    size_t Functions = 0;
+    size_t Instructions = 0;
+};
+
+ModuleSize GetModuleSize(const llvm::Module& M) {
+    ModuleSize Size;
+    for (const auto& F : M) {
+        if (!F.isDeclaration()) {
+            Size.Functions++;
+            Size.Instructions += F.getInstructionCount();
+        }
+    }
+    return Size;
+}
+
+} // anonymous namespace
+
+size_t StripUnreachable(llvm::Module& M, const std::vector<std::string>& Roots) {
+    const auto Before = GetModuleSize(M);
+
+    std::unordered_set<std::string> RootSet(Roots.begin(), Roots.end());
+    std::vector<const llvm::GlobalValue*> RootGlobals;
+    for (const auto& Global : M.global_values()) {
+        const auto Name = Global.getName();
+        const bool Lifted = Name.startswith("sub_") && !Global.isDeclaration();
+        if (Lifted || Name.startswith("llvm.") || RootSet.count(Name.str())) {
+            RootGlobals.push_back(&Global);
+        }
+    }
+    llvm::SmallPtrSet<const llvm::GlobalValue*, 32> Reachable;
+    CollectReachableGlobals(RootGlobals, Reachable);
+
+    // Dead globals may still refer to each other, cut those references before
+    // anything is erased
+    std::vector<llvm::GlobalValue*> Dead;
+    for (auto& Global : M.global_values()) {
+        if (!Reachable.count(&Global)) {
+            Dead.push_back(&Global);
+        }
+    }
+    for (auto* Global : Dead) {
+        if (auto* Function = llvm::dyn_cast<llvm::Function>(Global)) {
+            Function->dropAllReferences();
+        } else if (auto* Variable = llvm::dyn_cast<llvm::GlobalVariable>(Global)) {
+            Variable->setInitializer(nullptr);
+        } else if (auto* Alias = llvm::dyn_cast<llvm::GlobalAlias>(Global)) {
+            Alias->setAliasee(llvm::UndefValue::get(Alias->getType()));
+        }
+    }
+    for (auto* Global : Dead) {
+        Global->removeDeadConstantUsers();
+        Global->eraseFromParent();
+    }
+
+    const auto After = GetModuleSize(M);
+    LOG(INFO) << "Stripped " << Dead.size() << " unreachable globals: " << Before.Functions << " -> "
+              << After.Functions << " functions, " << Before.Instructions << " -> " << After.Instructions
+              << " instructions";
+    return Dead.size();
+}
+
+} // namespace BitcodeManipulation
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace BitcodeManipulation {
+
+// Delete every function, global variable and alias not reachable from the
+// roots, the lifted sub_* functions or the llvm.* globals. Meant to run on the
+// merged module before optimization, so the semantics and runtime helpers no
+// lifted block uses are not processed at all. Returns the number of globals
+// removed.
+size_t StripUnreachable(llvm::Module& M, const std::vector<std::string>& Roots);
+
+} // namespace BitcodeManipulation
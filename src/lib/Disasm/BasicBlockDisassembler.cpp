@@ -1,87 +1,202 @@
 #include "BasicBlockDisassembler.h"
 
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/Format.h>
 #include <glog/logging.h>
+#include <algorithm>
+#include <array>
 #include <iomanip>
 #include <sstream>
 
-BasicBlockDisassembler::BasicBlockDisassembler(size_t max_inst)
-    : max_instructions(max_inst) {}
+BasicBlockDisassembler::BasicBlockDisassembler(size_t max_inst, DecodeCache* cache_)
+    : disasm(XEDDisassembler::Get()), max_instructions(max_inst), cache(cache_) {}
 
 std::vector<DecodedInstruction> BasicBlockDisassembler::DisassembleBlock(
     const uint8_t* memory, size_t size, uint64_t start_addr) {
     
-    std::vector<DecodedInstruction> instructions;
-    const uint8_t* current_bytes = memory;
-    size_t remaining = size;
+    std::vector<DecodedInstruction> instructions(max_instructions);
+    instructions.resize(DisassembleBlock(memory, size, start_addr, instructions));
+    return instructions;
+}
+
+size_t BasicBlockDisassembler::DisassembleBlock(
+    const uint8_t* memory, size_t size, uint64_t start_addr,
+    llvm::MutableArrayRef<DecodedInstruction> out) {
+
+    MemoryByteSource source(memory, size, start_addr);
+    return DisassembleBlock(source, start_addr, out);
+}
+
+size_t BasicBlockDisassembler::DisassembleBlock(
+    ByteSource& source, uint64_t start_addr,
+    llvm::MutableArrayRef<DecodedInstruction> out,
+    uint64_t stop_addr) {
+
+    const size_t limit = std::min(max_instructions, out.size());
+    size_t count = 0;
     uint64_t current_addr = start_addr;
+    std::array<uint8_t, kMaxInstructionBytes> scratch;
 
-    std::string addr_str;
-    llvm::raw_string_ostream rso(addr_str);
-    rso << llvm::format_hex_no_prefix(start_addr, 16);
-    
-    VLOG(1) << "Disassembling block at " << addr_str << ":";
+    VLOG(1) << "Disassembling block at " << std::hex << std::setw(16) << std::setfill('0') << start_addr << ":";
     VLOG(1) << "----------------------------------------";
 
-    while (remaining > 0 && instructions.size() < max_instructions) {
-        auto inst = disasm.DecodeInstruction(current_bytes, remaining, current_addr);
-        if (inst.length == 0) {
+    // A stop at or before the start does not cut this block
+    const bool bounded = stop_addr > start_addr;
+    while (count < limit) {
+        if (bounded && current_addr >= stop_addr) {
+            VLOG(1) << "Block falls through to the block at " << std::hex << stop_addr;
             break;
         }
-
-        // Build the log message using stringstream for better formatting
-        std::stringstream ss;
-        addr_str.clear();
-        rso << llvm::format_hex_no_prefix(inst.address, 16);
-        ss << addr_str << ": ";
-        
-        // Print bytes without 0x prefix
-        for (const auto& byte : inst.bytes) {
-            std::string byte_str;
-            llvm::raw_string_ostream byte_rso(byte_str);
-            byte_rso << llvm::format_hex_no_prefix(static_cast<uint32_t>(byte), 2);
-            ss << byte_str;
+        auto bytes = source.Fetch(current_addr, kMaxInstructionBytes);
+        if (bytes.empty()) {
+            break;
         }
-        
-        // Pad with spaces for alignment (assuming max 15 bytes per instruction)
-        for (size_t i = inst.bytes.size(); i < 10; ++i) {
-            ss << "  ";
+
+        auto& inst = out[count];
+        // A cached instruction must still fit in the bytes the source has
+        if (!cache || !cache->Lookup(current_addr, inst) || inst.length > bytes.size()) {
+            // Too short for any instruction, join the following views
+            if (bytes.size() < kMaxInstructionBytes) {
+                size_t filled = 0;
+                while (!bytes.empty() && filled < scratch.size()) {
+                    const size_t take = std::min(bytes.size(), scratch.size() - filled);
+                    std::copy(bytes.begin(), bytes.begin() + take, scratch.begin() + filled);
+                    filled += take;
+                    bytes = filled < scratch.size() ? source.Fetch(current_addr + filled, scratch.size() - filled)
+                                                    : llvm::ArrayRef<uint8_t>();
+                }
+                bytes = llvm::ArrayRef<uint8_t>(scratch.data(), filled);
+            }
+            inst = disasm.DecodeInstruction(bytes.data(), bytes.size(), current_addr);
+            if (cache) {
+                cache->Insert(inst);
+            }
         }
-        
-        // Print instruction type
-        if (inst.is_branch) ss << "[branch] ";
-        else if (inst.is_call) ss << "[call] ";
-        else if (inst.is_ret) ss << "[ret] ";
-        else if (inst.is_int3) ss << "[int3] ";
-        else ss << "        ";
-        
-        // Print assembly with proper padding
-        if (!inst.assembly.empty()) {
-            ss << inst.assembly;
+        if (inst.length == 0) {
+            break;
         }
-        LOG(INFO) << ss.str();
+        count++;
 
-        instructions.push_back(inst);
+        // Formatting is the expensive part, only do it when the listing is shown
+        if (VLOG_IS_ON(1)) {
+            LogInstruction(inst);
+        }
         
         if (disasm.IsTerminator(inst)) {
             std::string terminator_type;
-            if (inst.is_branch) terminator_type = "branch instruction";
-            else if (inst.is_call) terminator_type = "call instruction";
-            else if (inst.is_ret) terminator_type = "return instruction";
-            else if (inst.is_int3) terminator_type = "int3 instruction";
+            if (inst.IsBranch()) terminator_type = "branch instruction";
+            else if (inst.IsCall()) terminator_type = "call instruction";
+            else if (inst.IsRet()) terminator_type = "return instruction";
+            else if (inst.IsInt3()) terminator_type = "int3 instruction";
             else terminator_type = "terminator instruction";
             VLOG(1) << "Block terminated by " << terminator_type;
             break;
         }
 
-        current_bytes += inst.length;
         current_addr += inst.length;
-        remaining -= inst.length;
     }
 
     VLOG(1) << "----------------------------------------";
-    VLOG(1) << "Total instructions: " << instructions.size() << "\n";
+    VLOG(1) << "Total instructions: " << count << "\n";
 
-    return instructions;
-} 
\ No newline at end of file
+    return count;
+}
+
+size_t BasicBlockDisassembler::DisassembleSuperblock(
+    ByteSource& source, uint64_t start_addr,
+    llvm::MutableArrayRef<DecodedInstruction> out,
+    std::vector<uint64_t>& callees,
+    const std::function<bool(uint64_t)>& is_known,
+    uint64_t stop_addr) {
+
+    struct Segment {
+        uint64_t address;
+        bool callee;
+    };
+    // The top segment is the one executed next: a callee before the code
+    // its call returns to
+    llvm::SmallVector<Segment, 8> pending = {{start_addr, false}};
+    size_t count = 0;
+    const auto is_decoded = [&out, &count](uint64_t address) {
+        return std::any_of(out.begin(), out.begin() + count,
+                           [address](const DecodedInstruction& inst) { return inst.address == address; });
+    };
+    const auto add_callee = [&callees, start_addr](uint64_t address) {
+        if (address != start_addr && std::find(callees.begin(), callees.end(), address) == callees.end()) {
+            callees.push_back(address);
+        }
+    };
+
+    while (!pending.empty() && count < out.size()) {
+        const Segment segment = pending.pop_back_val();
+        if (segment.callee && is_known && is_known(segment.address)) {
+            continue;
+        }
+        if (is_decoded(segment.address)) {
+            // Decoded on another path, but a call still makes it a function
+            if (segment.callee) {
+                add_callee(segment.address);
+            }
+            continue;
+        }
+        const size_t decoded = DisassembleBlock(source, segment.address, out.drop_front(count), stop_addr);
+        if (decoded == 0) {
+            // Left to the missing block handler
+            continue;
+        }
+        if (segment.callee) {
+            add_callee(segment.address);
+        }
+        count += decoded;
+
+        const auto& last = out[count - 1];
+        const bool reached_stop = segment.address < stop_addr && last.GetNextAddress() >= stop_addr;
+        if (!last.IsTerminator() && !reached_stop) {
+            // Cut by the block instruction limit, not by control flow
+            pending.push_back({last.GetNextAddress(), false});
+        } else if (last.IsCall() && last.HasTarget()) {
+            pending.push_back({last.GetNextAddress(), false});
+            // call $+5 only pushes its own address, there is no callee to follow
+            if (last.target != last.GetNextAddress()) {
+                pending.push_back({last.target, true});
+            }
+        } else if (last.IsBranch() && !last.IsCondBranch() && last.HasTarget()) {
+            pending.push_back({last.target, false});
+        }
+    }
+
+    VLOG(1) << "Superblock at " << std::hex << start_addr << ": " << std::dec << count << " instructions, "
+            << callees.size() << " callees";
+    return count;
+}
+
+void BasicBlockDisassembler::LogInstruction(const DecodedInstruction& inst) const {
+    // Build the log message using stringstream for better formatting
+    std::stringstream ss;
+    std::string addr_str;
+    llvm::raw_string_ostream rso(addr_str);
+    rso << llvm::format_hex_no_prefix(inst.address, 16);
+    ss << rso.str() << ": ";
+    
+    // Print bytes without 0x prefix
+    for (const auto byte : inst.GetBytes()) {
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(byte);
+    }
+    
+    // Pad with spaces for alignment (assuming max 15 bytes per instruction)
+    for (size_t i = inst.length; i < 10; ++i) {
+        ss << "  ";
+    }
+    
+    // Print instruction type
+    if (inst.IsBranch()) ss << "[branch] ";
+    else if (inst.IsCall()) ss << "[call] ";
+    else if (inst.IsRet()) ss << "[ret] ";
+    else if (inst.IsInt3()) ss << "[int3] ";
+    else ss << "        ";
+    
+    // Print assembly with proper padding
+    ss << disasm.FormatInstruction(inst);
+    VLOG(1) << ss.str();
+}
@@ -1,17 +1,68 @@
 #pragma once
 
+#include "Disasm/ByteSource.h"
 #include "Disasm/XEDDisassembler.h"
+#include "Disasm/DecodeCache.h"
 
-// Class to handle basic block disassembly
+#include <llvm/ADT/ArrayRef.h>
+
+#include <functional>
+
+// Class to handle basic block disassembly. Decodes through the process-wide
+// XEDDisassembler and keeps no state of its own besides the thread-safe
+// cache, so one instance can be shared between threads.
 class BasicBlockDisassembler {
 public:
-    BasicBlockDisassembler(size_t max_inst = 32);
+    // With a cache, instructions seen before are taken from it instead of
+    // being decoded again, the cache must outlive the disassembler
+    BasicBlockDisassembler(size_t max_inst = 32, DecodeCache* cache = nullptr);
     
     std::vector<DecodedInstruction> DisassembleBlock(const uint8_t* memory, 
                                                     size_t size, 
                                                     uint64_t start_addr);
 
+    // Decode into caller-owned storage without heap allocations. Stops at the
+    // first terminator, the instruction limit or the end of `out`. Returns the
+    // number of instructions written
+    size_t DisassembleBlock(const uint8_t* memory,
+                            size_t size,
+                            uint64_t start_addr,
+                            llvm::MutableArrayRef<DecodedInstruction> out);
+
+    // Same, pulling bytes from the source one instruction at a time so the
+    // read ends exactly at the terminator. Instructions crossing a view end,
+    // e.g. a page boundary, are put together in a 15 byte scratch buffer.
+    // Decoding also stops at `stop_addr` when the block reaches it, e.g. the
+    // start of a block lifted before; the block then falls through to it.
+    size_t DisassembleBlock(ByteSource& source,
+                            uint64_t start_addr,
+                            llvm::MutableArrayRef<DecodedInstruction> out,
+                            uint64_t stop_addr = UINT64_MAX);
+
+    // Superblock: keeps decoding past unconditional direct jumps at their
+    // target, and past direct calls in the callee and then at the return
+    // address, until `out` is full. A path ends at any other terminator or at
+    // code already decoded. The lifter follows the same edges within one
+    // trace, with every callee becoming its own function; the callee entries
+    // that were decoded are appended to `callees`. Callees `is_known` accepts
+    // are functions lifted before, they are not followed and their calls are
+    // left to the missing block handler. No path is decoded past `stop_addr`
+    // once it reaches it. Returns the number of instructions written, the
+    // entry block comes first.
+    size_t DisassembleSuperblock(ByteSource& source,
+                                 uint64_t start_addr,
+                                 llvm::MutableArrayRef<DecodedInstruction> out,
+                                 std::vector<uint64_t>& callees,
+                                 const std::function<bool(uint64_t)>& is_known = nullptr,
+                                 uint64_t stop_addr = UINT64_MAX);
+
+    size_t GetMaxInstructions() const { return max_instructions; }
+    const DecodeCache* GetCache() const { return cache; }
+
 private:
-    XEDDisassembler disasm;
+    const XEDDisassembler& disasm;
     size_t max_instructions;
+    DecodeCache* cache;
+
+    void LogInstruction(const DecodedInstruction& inst) const;
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Disasm/DecodedInstruction.h"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Code bytes pulled on demand while a block is decoded. Fetch returns a view
+// starting at the address that may be shorter than asked for, e.g. cut at a
+// page end, and is empty if nothing can be read there. A view only has to
+// stay valid until the next Fetch.
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    virtual llvm::ArrayRef<uint8_t> Fetch(uint64_t address, size_t size) = 0;
+};
+
+// Bytes already in memory, mapped at `base`
+class MemoryByteSource : public ByteSource {
+public:
+    MemoryByteSource(const uint8_t* memory, size_t size, uint64_t base)
+        : memory(memory), size(size), base(base) {}
+
+    llvm::ArrayRef<uint8_t> Fetch(uint64_t address, size_t count) override {
+        if (address < base || address - base >= size) {
+            return {};
+        }
+        const uint64_t offset = address - base;
+        return llvm::ArrayRef<uint8_t>(memory + offset, std::min<uint64_t>(count, size - offset));
+    }
+
+private:
+    const uint8_t* memory;
+    size_t size;
+    uint64_t base;
+};
+
+// Bytes of decoded instructions, which need not be contiguous. A view ends
+// with the instruction the address falls in.
+class InstructionByteSource : public ByteSource {
+public:
+    explicit InstructionByteSource(llvm::ArrayRef<DecodedInstruction> decoded)
+        : instructions(decoded.begin(), decoded.end()) {
+        std::sort(instructions.begin(), instructions.end(),
+                  [](const DecodedInstruction& a, const DecodedInstruction& b) { return a.address < b.address; });
+    }
+
+    llvm::ArrayRef<uint8_t> Fetch(uint64_t address, size_t count) override {
+        auto it = std::upper_bound(instructions.begin(), instructions.end(), address,
+                                   [](uint64_t address, const DecodedInstruction& inst) { return address < inst.address; });
+        if (it == instructions.begin() || address >= std::prev(it)->GetNextAddress()) {
+            return {};
+        }
+        const auto& inst = *std::prev(it);
+        const uint64_t offset = address - inst.address;
+        return llvm::ArrayRef<uint8_t>(inst.bytes.data() + offset, std::min<uint64_t>(count, inst.length - offset));
+    }
+
+private:
+    std::vector<DecodedInstruction> instructions;
+};
@@ -0,0 +1,81 @@
+#include "DecodeCache.h"
+
+#include <algorithm>
+#include <mutex>
+
+DecodeCache::DecodeCache(uint64_t page_size)
+    : page_mask(~(page_size - 1)) {}
+
+bool DecodeCache::Lookup(uint64_t address, DecodedInstruction& inst) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = instructions.find(address);
+    if (it == instructions.end()) {
+        misses++;
+        return false;
+    }
+    hits++;
+    inst = it->second;
+    return true;
+}
+
+void DecodeCache::Insert(const DecodedInstruction& inst) {
+    if (inst.length == 0) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!instructions.emplace(inst.address, inst).second) {
+        return;
+    }
+    const uint64_t first_page = inst.address & page_mask;
+    const uint64_t last_page = (inst.address + inst.length - 1) & page_mask;
+    page_index[first_page].push_back(inst.address);
+    if (last_page != first_page) {
+        page_index[last_page].push_back(inst.address);
+    }
+}
+
+void DecodeCache::InvalidatePage(uint64_t address) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = page_index.find(address & page_mask);
+    if (it == page_index.end()) {
+        return;
+    }
+    const uint64_t page = it->first;
+    for (const auto inst_address : it->second) {
+        // Instructions spanning two pages are also listed under the other one
+        const auto inst = instructions.find(inst_address);
+        if (inst == instructions.end()) {
+            continue;
+        }
+        const uint64_t first_page = inst_address & page_mask;
+        const uint64_t last_page = (inst_address + inst->second.length - 1) & page_mask;
+        if (first_page != last_page) {
+            auto other = page_index.find(first_page == page ? last_page : first_page);
+            if (other != page_index.end()) {
+                auto& addresses = other->second;
+                addresses.erase(std::remove(addresses.begin(), addresses.end(), inst_address), addresses.end());
+                if (addresses.empty()) {
+                    page_index.erase(other);
+                }
+            }
+        }
+        instructions.erase(inst);
+    }
+    page_index.erase(it);
+}
+
+void DecodeCache::Clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    instructions.clear();
+    page_index.clear();
+}
+
+double DecodeCache::GetHitRate() const {
+    const size_t total = hits + misses;
+    return total ? static_cast<double>(hits) / total : 0.0;
+}
+
+size_t DecodeCache::GetSize() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return instructions.size();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Disasm/DecodedInstruction.h"
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// Decoded instructions by address, shared by everything that decodes in a
+// session. Entries are indexed by every page their bytes touch, so a page
+// can be invalidated on its own when its contents change.
+class DecodeCache {
+public:
+    explicit DecodeCache(uint64_t page_size = 0x1000);
+
+    // Copies the cached instruction into `inst`, false on a miss
+    bool Lookup(uint64_t address, DecodedInstruction& inst) const;
+    void Insert(const DecodedInstruction& inst);
+
+    // Drop every instruction with bytes in the page containing the address
+    void InvalidatePage(uint64_t address);
+    void Clear();
+
+    size_t GetHits() const { return hits; }
+    size_t GetMisses() const { return misses; }
+    double GetHitRate() const;
+    size_t GetSize() const;
+
+private:
+    uint64_t page_mask;
+    mutable std::shared_mutex mutex;
+    std::unordered_map<uint64_t, DecodedInstruction> instructions;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> page_index;  // page -> instruction addresses
+    mutable std::atomic<size_t> hits{0};
+    mutable std::atomic<size_t> misses{0};
+};
@@ -1,17 +1,47 @@
 #pragma once
 
-#include <vector>
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <string>
+#include <type_traits>
 
-// Structure to hold decoded instruction information
+#include <llvm/ADT/ArrayRef.h>
+
+// Longest x86 instruction
+constexpr size_t kMaxInstructionBytes = 15;
+
+// Decoded instruction, kept small and trivially copyable so blocks can be
+// decoded into caller-owned buffers without heap allocations. The text form
+// is not stored, XEDDisassembler::FormatInstruction produces it on demand.
 struct DecodedInstruction {
-    std::vector<uint8_t> bytes;
-    size_t length;
-    uint64_t address;
-    bool is_branch;
-    bool is_call;
-    bool is_ret;
-    bool is_int3;
-    std::string assembly;  // Assembly text representation
+    enum Flags : uint8_t {
+        kBranch = 1 << 0,
+        kCondBranch = 1 << 1,
+        kCall = 1 << 2,
+        kRet = 1 << 3,
+        kInt3 = 1 << 4,
+        kHasTarget = 1 << 5,    // Direct branch or call
+    };
+
+    uint64_t address = 0;
+    uint64_t target = 0;        // Valid with kHasTarget
+    uint16_t iclass = 0;        // xed_iclass_enum_t
+    uint8_t category = 0;       // xed_category_enum_t
+    uint8_t length = 0;         // 0 if decoding failed
+    uint8_t flags = 0;
+    std::array<uint8_t, kMaxInstructionBytes> bytes = {};
+
+    bool IsBranch() const { return flags & kBranch; }
+    bool IsCondBranch() const { return flags & kCondBranch; }
+    bool IsCall() const { return flags & kCall; }
+    bool IsRet() const { return flags & kRet; }
+    bool IsInt3() const { return flags & kInt3; }
+    bool HasTarget() const { return flags & kHasTarget; }
+    bool IsTerminator() const { return flags & (kBranch | kCall | kRet | kInt3); }
+
+    uint64_t GetNextAddress() const { return address + length; }
+    llvm::ArrayRef<uint8_t> GetBytes() const { return llvm::ArrayRef<uint8_t>(bytes.data(), length); }
 };
+
+static_assert(std::is_trivially_copyable<DecodedInstruction>::value, "DecodedInstruction must stay trivially copyable");
+static_assert(sizeof(DecodedInstruction) <= 40, "DecodedInstruction grew");
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Operands of a decoded instruction in the shape the static analyses need.
+// Registers are xed_reg_enum_t values widened to their 64-bit parent, so
+// ecx and rcx compare equal. RIP-relative addresses are already resolved.
+struct InstructionOperands {
+    enum class Kind : uint8_t {
+        Other,              // Anything else, assumed to write its first register
+        Mov,
+        MovSignExtend,      // movsx, movsxd
+        MovZeroExtend,      // movzx
+        Lea,
+        Add,
+        Cmp,
+        Test,
+        Jump,               // Unconditional jmp
+        JumpAbove,          // ja
+        JumpAboveOrEqual,   // jae
+        CondJump,           // Any other conditional jump
+    };
+
+    Kind kind = Kind::Other;
+    uint8_t reg_count = 0;
+    uint16_t regs[2] = {0, 0};  // Explicit register operands in operand order
+
+    bool has_memory = false;    // Memory operand or lea address
+    uint16_t base = 0;          // 0 if absent or RIP-relative
+    uint16_t index = 0;
+    uint8_t scale = 0;
+    uint8_t memory_size = 0;
+    int64_t displacement = 0;   // Absolute address for RIP-relative operands
+
+    bool has_immediate = false;
+    uint64_t immediate = 0;     // Sign-extended to 64 bits
+};
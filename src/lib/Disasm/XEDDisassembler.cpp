@@ -2,6 +2,9 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <mutex>
+
 extern "C" {
 #define XED_DLL
 #include <xed/xed-interface.h>
@@ -13,12 +16,19 @@ XEDDisassembler::XEDDisassembler() {
 
 XEDDisassembler::~XEDDisassembler() = default;
 
+const XEDDisassembler& XEDDisassembler::Get() {
+    static const XEDDisassembler instance;
+    return instance;
+}
+
 void XEDDisassembler::Initialize() {
-    xed_tables_init();
+    // Table setup is not thread-safe, disassemblers may be created concurrently
+    static std::once_flag tables_initialized;
+    std::call_once(tables_initialized, xed_tables_init);
 }
 
 DecodedInstruction 
-XEDDisassembler::DecodeInstruction(const uint8_t* bytes, size_t max_size, uint64_t addr) {
+XEDDisassembler::DecodeInstruction(const uint8_t* bytes, size_t max_size, uint64_t addr) const {
     DecodedInstruction result;
     result.address = addr;
 
@@ -26,36 +36,154 @@ XEDDisassembler::DecodeInstruction(const uint8_t* bytes, size_t max_size, uint64
     xed_decoded_inst_zero(&xedd);
     xed_decoded_inst_set_mode(&xedd, XED_MACHINE_MODE_LONG_64, XED_ADDRESS_WIDTH_64b);
     
-    xed_error_enum_t error = xed_decode(&xedd, bytes, max_size);
+    xed_error_enum_t error = xed_decode(&xedd, bytes, std::min<size_t>(max_size, kMaxInstructionBytes));
     if (error != XED_ERROR_NONE) {
         LOG(ERROR) << "Failed to decode instruction at 0x" << std::hex << addr;
         return result;
     }
 
     result.length = xed_decoded_inst_get_length(&xedd);
-    result.bytes = std::vector<uint8_t>(bytes, bytes + result.length);
+    std::copy(bytes, bytes + result.length, result.bytes.begin());
 
     // Get instruction category
     xed_category_enum_t category = xed_decoded_inst_get_category(&xedd);
     xed_iclass_enum_t iclass = xed_decoded_inst_get_iclass(&xedd);
+    result.category = static_cast<uint8_t>(category);
+    result.iclass = static_cast<uint16_t>(iclass);
 
-    result.is_branch = (category == XED_CATEGORY_COND_BR || 
-                       category == XED_CATEGORY_UNCOND_BR);
-    result.is_call = (category == XED_CATEGORY_CALL);
-    result.is_ret = (category == XED_CATEGORY_RET);
-    result.is_int3 = (iclass == XED_ICLASS_INT3);
+    if (category == XED_CATEGORY_COND_BR) {
+        result.flags |= DecodedInstruction::kBranch | DecodedInstruction::kCondBranch;
+    } else if (category == XED_CATEGORY_UNCOND_BR) {
+        result.flags |= DecodedInstruction::kBranch;
+    } else if (category == XED_CATEGORY_CALL) {
+        result.flags |= DecodedInstruction::kCall;
+    } else if (category == XED_CATEGORY_RET) {
+        result.flags |= DecodedInstruction::kRet;
+    }
+    if (iclass == XED_ICLASS_INT3) {
+        result.flags |= DecodedInstruction::kInt3;
+    }
 
-    // Get assembly text
-    char buffer[256];
-    if (xed_format_context(XED_SYNTAX_INTEL, &xedd, buffer, sizeof(buffer), addr, nullptr, nullptr)) {
-        result.assembly = buffer;
-    } else {
-        result.assembly = "<decode error>";
+    // Relative branch target, resolved against the next instruction
+    if (xed_operand_values_has_branch_displacement(xed_decoded_inst_operands_const(&xedd))) {
+        result.flags |= DecodedInstruction::kHasTarget;
+        result.target = addr + result.length + static_cast<int64_t>(xed_decoded_inst_get_branch_displacement(&xedd));
     }
 
     return result;
 }
 
+std::string XEDDisassembler::FormatInstruction(const DecodedInstruction& inst) const {
+    xed_decoded_inst_t xedd;
+    xed_decoded_inst_zero(&xedd);
+    xed_decoded_inst_set_mode(&xedd, XED_MACHINE_MODE_LONG_64, XED_ADDRESS_WIDTH_64b);
+    if (inst.length == 0 || xed_decode(&xedd, inst.bytes.data(), inst.length) != XED_ERROR_NONE) {
+        return "<decode error>";
+    }
+
+    char buffer[256];
+    if (!xed_format_context(XED_SYNTAX_INTEL, &xedd, buffer, sizeof(buffer), inst.address, nullptr, nullptr)) {
+        return "<decode error>";
+    }
+    return buffer;
+}
+
+bool XEDDisassembler::DecodeOperands(const DecodedInstruction& inst, InstructionOperands& operands) const {
+    xed_decoded_inst_t xedd;
+    xed_decoded_inst_zero(&xedd);
+    xed_decoded_inst_set_mode(&xedd, XED_MACHINE_MODE_LONG_64, XED_ADDRESS_WIDTH_64b);
+    if (inst.length == 0 || xed_decode(&xedd, inst.bytes.data(), inst.length) != XED_ERROR_NONE) {
+        return false;
+    }
+
+    operands = InstructionOperands();
+    switch (xed_decoded_inst_get_iclass(&xedd)) {
+    case XED_ICLASS_MOV: operands.kind = InstructionOperands::Kind::Mov; break;
+    case XED_ICLASS_MOVSX:
+    case XED_ICLASS_MOVSXD: operands.kind = InstructionOperands::Kind::MovSignExtend; break;
+    case XED_ICLASS_MOVZX: operands.kind = InstructionOperands::Kind::MovZeroExtend; break;
+    case XED_ICLASS_LEA: operands.kind = InstructionOperands::Kind::Lea; break;
+    case XED_ICLASS_ADD: operands.kind = InstructionOperands::Kind::Add; break;
+    case XED_ICLASS_CMP: operands.kind = InstructionOperands::Kind::Cmp; break;
+    case XED_ICLASS_TEST: operands.kind = InstructionOperands::Kind::Test; break;
+    case XED_ICLASS_JMP: operands.kind = InstructionOperands::Kind::Jump; break;
+    case XED_ICLASS_JNBE: operands.kind = InstructionOperands::Kind::JumpAbove; break;
+    case XED_ICLASS_JNB: operands.kind = InstructionOperands::Kind::JumpAboveOrEqual; break;
+    default:
+        if (xed_decoded_inst_get_category(&xedd) == XED_CATEGORY_COND_BR) {
+            operands.kind = InstructionOperands::Kind::CondJump;
+        }
+        break;
+    }
+
+    const xed_inst_t* xi = xed_decoded_inst_inst(&xedd);
+    for (unsigned i = 0; i < xed_inst_noperands(xi); i++) {
+        const xed_operand_t* op = xed_inst_operand(xi, i);
+        if (xed_operand_operand_visibility(op) == XED_OPVIS_SUPPRESSED) {
+            continue;
+        }
+        const xed_operand_enum_t name = xed_operand_name(op);
+        if (xed_operand_is_register(name)) {
+            if (operands.reg_count < 2) {
+                const xed_reg_enum_t reg = xed_decoded_inst_get_reg(&xedd, name);
+                operands.regs[operands.reg_count++] = static_cast<uint16_t>(xed_get_largest_enclosing_register(reg));
+            }
+        } else if (name == XED_OPERAND_MEM0 || name == XED_OPERAND_AGEN) {
+            const xed_reg_enum_t base = xed_decoded_inst_get_base_reg(&xedd, 0);
+            const xed_reg_enum_t index = xed_decoded_inst_get_index_reg(&xedd, 0);
+            operands.has_memory = true;
+            operands.index = index == XED_REG_INVALID ? 0 : static_cast<uint16_t>(xed_get_largest_enclosing_register(index));
+            operands.scale = static_cast<uint8_t>(xed_decoded_inst_get_scale(&xedd, 0));
+            operands.memory_size = static_cast<uint8_t>(xed_decoded_inst_get_memory_operand_length(&xedd, 0));
+            operands.displacement = xed_decoded_inst_get_memory_displacement(&xedd, 0);
+            if (base == XED_REG_RIP) {
+                operands.displacement += static_cast<int64_t>(inst.GetNextAddress());
+            } else if (base != XED_REG_INVALID) {
+                operands.base = static_cast<uint16_t>(xed_get_largest_enclosing_register(base));
+            }
+        } else if (name == XED_OPERAND_IMM0) {
+            operands.has_immediate = true;
+            operands.immediate = xed_decoded_inst_get_immediate_is_signed(&xedd)
+                ? static_cast<uint64_t>(static_cast<int64_t>(xed_decoded_inst_get_signed_immediate(&xedd)))
+                : xed_decoded_inst_get_unsigned_immediate(&xedd);
+        }
+    }
+    return true;
+}
+
 bool XEDDisassembler::IsTerminator(const DecodedInstruction& inst) const {
-    return inst.is_branch || inst.is_call || inst.is_ret || inst.is_int3;
-} 
\ No newline at end of file
+    return inst.IsTerminator();
+}
+
+InstructionLength XEDDisassembler::DecodeLength(const uint8_t* bytes, size_t max_size) const {
+    InstructionLength result;
+
+    xed_decoded_inst_t xedd;
+    xed_decoded_inst_zero(&xedd);
+    xed_decoded_inst_set_mode(&xedd, XED_MACHINE_MODE_LONG_64, XED_ADDRESS_WIDTH_64b);
+    if (xed_ild_decode(&xedd, bytes, std::min<size_t>(max_size, kMaxInstructionBytes)) != XED_ERROR_NONE) {
+        return result;
+    }
+
+    result.length = xed_decoded_inst_get_length(&xedd);
+    result.map = static_cast<uint8_t>(xed3_operand_get_map(&xedd));
+    result.opcode = static_cast<uint8_t>(xed3_operand_get_nominal_opcode(&xedd));
+    result.modrm_reg = static_cast<uint8_t>(xed3_operand_get_reg(&xedd));
+    return result;
+}
+
+bool InstructionLength::IsControlFlowCandidate() const {
+    if (map == 0) {
+        return (opcode >= 0x70 && opcode <= 0x7f) ||    // jcc rel8
+               (opcode >= 0xe0 && opcode <= 0xe3) ||    // loop, jrcxz
+               (opcode >= 0xe8 && opcode <= 0xeb) ||    // call, jmp
+               opcode == 0xc2 || opcode == 0xc3 ||      // ret
+               opcode == 0xca || opcode == 0xcb ||      // far ret
+               opcode == 0xcc || opcode == 0xcf ||      // int3, iret
+               (opcode == 0xff && modrm_reg >= 2 && modrm_reg <= 5);  // indirect call, jmp
+    }
+    if (map == 1) {
+        return opcode >= 0x80 && opcode <= 0x8f;        // jcc rel32
+    }
+    return false;
+}
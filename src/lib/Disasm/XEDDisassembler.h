@@ -3,16 +3,44 @@
 #include <cstdint>
 #include <string>
 #include "DecodedInstruction.h"
+#include "InstructionOperands.h"
 
-// Class to handle disassembly using XED
+// Result of a length-only decode, enough to spot control flow without a full decode
+struct InstructionLength {
+    uint8_t length = 0;     // 0 if the bytes are not an instruction
+    uint8_t map = 0;        // Opcode map, 0 for one-byte opcodes, 1 for 0f xx
+    uint8_t opcode = 0;     // Nominal opcode byte
+    uint8_t modrm_reg = 0;  // ModRM.reg, selects the operation of group opcodes
+
+    // May transfer control, a full decode tells which way
+    bool IsControlFlowCandidate() const;
+};
+
+// Class to handle disassembly using XED. XED's tables are initialized once
+// per process and every call keeps its decode state on the calling thread's
+// stack, so all methods are reentrant and one instance can serve any number
+// of threads.
 class XEDDisassembler {
 public:
     XEDDisassembler();
     ~XEDDisassembler();
 
-    DecodedInstruction DecodeInstruction(const uint8_t* bytes, size_t max_size, uint64_t addr);
+    // Process-wide instance, initialized on first use
+    static const XEDDisassembler& Get();
+
+    // Decode without formatting, `length` is 0 if the bytes are not an instruction
+    DecodedInstruction DecodeInstruction(const uint8_t* bytes, size_t max_size, uint64_t addr) const;
     bool IsTerminator(const DecodedInstruction& inst) const;
 
+    // Decode the stored bytes again for their operands, false if they don't decode
+    bool DecodeOperands(const DecodedInstruction& inst, InstructionOperands& operands) const;
+
+    // Instruction length decoder only, several times cheaper than DecodeInstruction
+    InstructionLength DecodeLength(const uint8_t* bytes, size_t max_size) const;
+
+    // Intel syntax text, decoded again from the stored bytes
+    std::string FormatInstruction(const DecodedInstruction& inst) const;
+
 private:
     void Initialize();
 };
@@ -0,0 +1,43 @@
+#include "DiscoveryCaches.h"
+
+#include <algorithm>
+
+namespace Discovery {
+
+bool LiftedBlockCache::Claim(uint64_t address) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blocks.emplace(address, State::Lifting).second;
+}
+
+void LiftedBlockCache::Finish(uint64_t address, bool lifted) {
+    std::lock_guard<std::mutex> lock(mutex);
+    blocks[address] = lifted ? State::Lifted : State::Failed;
+}
+
+bool LiftedBlockCache::IsLifted(uint64_t address) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = blocks.find(address);
+    return it != blocks.end() && it->second == State::Lifted;
+}
+
+size_t LiftedBlockCache::GetLiftedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::count_if(blocks.begin(), blocks.end(),
+                         [](const auto& block) { return block.second == State::Lifted; });
+}
+
+std::vector<uint64_t> LiftedBlockCache::GetLiftedBlocks() const {
+    std::vector<uint64_t> lifted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& [address, state] : blocks) {
+            if (state == State::Lifted) {
+                lifted.push_back(address);
+            }
+        }
+    }
+    std::sort(lifted.begin(), lifted.end());
+    return lifted;
+}
+
+}  // namespace Discovery
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Disasm/DecodeCache.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Discovery {
+
+// Ownership of block addresses across sessions, so every block is lifted by
+// exactly one of them no matter how many threads reach it
+class LiftedBlockCache {
+public:
+    enum class State : uint8_t {
+        Lifting,
+        Lifted,
+        Failed,
+    };
+
+    // True for the first caller, which must report the outcome with Finish
+    bool Claim(uint64_t address);
+    void Finish(uint64_t address, bool lifted);
+
+    bool IsLifted(uint64_t address) const;
+    size_t GetLiftedCount() const;
+
+    // Lifted block addresses in ascending order
+    std::vector<uint64_t> GetLiftedBlocks() const;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, State> blocks;
+};
+
+// Caches shared by every discovery session
+struct SharedCaches {
+    DecodeCache decoded;
+    LiftedBlockCache lifted;
+};
+
+}  // namespace Discovery
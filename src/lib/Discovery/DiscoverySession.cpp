@@ -0,0 +1,72 @@
+#include "DiscoverySession.h"
+
+#include <glog/logging.h>
+
+namespace Discovery {
+
+DiscoverySession::DiscoverySession(uint32_t thread_id_,
+                                   uint64_t start_address_,
+                                   SharedCaches& caches_,
+                                   CodeReader read_code_,
+                                   BlockLifter lift_block_,
+                                   size_t max_blocks_,
+                                   size_t max_block_instructions_)
+    : thread_id(thread_id_)
+    , start_address(start_address_)
+    , caches(caches_)
+    , read_code(std::move(read_code_))
+    , lift_block(std::move(lift_block_))
+    , max_blocks(max_blocks_)
+    , max_block_instructions(max_block_instructions_) {}
+
+void DiscoverySession::Run() {
+    LOG(INFO) << "Thread " << std::dec << thread_id << ": discovery from 0x" << std::hex << start_address;
+
+    std::vector<uint64_t> worklist = {start_address};
+    std::unordered_set<uint64_t> visited;
+    std::vector<DecodedInstruction> instructions;
+    std::vector<uint64_t> successors;
+
+    while (!worklist.empty() && blocks_lifted < max_blocks) {
+        const uint64_t address = worklist.back();
+        worklist.pop_back();
+        if (!visited.insert(address).second) {
+            continue;
+        }
+
+        instructions.clear();
+        if (!DecodeBlock(disasm, caches.decoded, read_code, address, max_block_instructions, instructions)) {
+            VLOG(1) << "Thread " << std::dec << thread_id << ": no code at 0x" << std::hex << address;
+            blocks_failed++;
+            continue;
+        }
+
+        // Successors are followed even when another session owns the block,
+        // this session may be the only one to reach the code past it
+        successors.clear();
+        GetSuccessors(instructions, max_block_instructions, successors);
+        for (const auto successor : successors) {
+            if (!visited.count(successor)) {
+                worklist.push_back(successor);
+            }
+        }
+
+        if (!caches.lifted.Claim(address)) {
+            blocks_shared++;
+            continue;
+        }
+        const bool lifted = lift_block(instructions, address);
+        caches.lifted.Finish(address, lifted);
+        if (lifted) {
+            blocks_lifted++;
+        } else {
+            LOG(WARNING) << "Thread " << std::dec << thread_id << ": failed to lift block at 0x" << std::hex << address;
+            blocks_failed++;
+        }
+    }
+
+    LOG(INFO) << "Thread " << std::dec << thread_id << ": " << blocks_lifted << " blocks lifted, "
+              << blocks_shared << " shared with other threads, " << blocks_failed << " failed";
+}
+
+}  // namespace Discovery
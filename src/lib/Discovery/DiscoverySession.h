@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Discovery/DiscoveryCaches.h"
+#include "Discovery/StaticDiscovery.h"
+#include "Disasm/XEDDisassembler.h"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+namespace Discovery {
+
+// Lifts one decoded block, must be safe to call from several sessions
+using BlockLifter = std::function<bool(llvm::ArrayRef<DecodedInstruction> instructions, uint64_t address)>;
+
+// Walks the code reachable from one thread context through direct control
+// flow and lifts every block it reaches. Sessions for different threads run
+// concurrently and share their caches, a block reached by several sessions
+// is lifted by the first one to claim it.
+class DiscoverySession {
+public:
+    DiscoverySession(uint32_t thread_id,
+                     uint64_t start_address,
+                     SharedCaches& caches,
+                     CodeReader read_code,
+                     BlockLifter lift_block,
+                     size_t max_blocks,
+                     size_t max_block_instructions = 32);
+
+    void Run();
+
+    uint32_t GetThreadId() const { return thread_id; }
+    uint64_t GetStartAddress() const { return start_address; }
+    size_t GetBlocksLifted() const { return blocks_lifted; }
+    size_t GetBlocksShared() const { return blocks_shared; }
+    size_t GetBlocksFailed() const { return blocks_failed; }
+
+private:
+    uint32_t thread_id;
+    uint64_t start_address;
+    SharedCaches& caches;
+    CodeReader read_code;
+    BlockLifter lift_block;
+    size_t max_blocks;
+    size_t max_block_instructions;
+    const XEDDisassembler& disasm = XEDDisassembler::Get();
+
+    size_t blocks_lifted = 0;
+    size_t blocks_shared = 0;
+    size_t blocks_failed = 0;
+};
+
+}  // namespace Discovery
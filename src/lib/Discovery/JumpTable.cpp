@@ -0,0 +1,216 @@
+#include "JumpTable.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <unordered_set>
+
+namespace Discovery {
+
+namespace {
+
+using Kind = InstructionOperands::Kind;
+
+// Compares, tests and jumps leave their register operands alone
+bool WritesRegister(const InstructionOperands& ops, uint16_t reg) {
+    if (ops.reg_count == 0 || ops.regs[0] != reg) {
+        return false;
+    }
+    return ops.kind != Kind::Cmp && ops.kind != Kind::Test &&
+           ops.kind != Kind::Jump && ops.kind != Kind::JumpAbove &&
+           ops.kind != Kind::JumpAboveOrEqual && ops.kind != Kind::CondJump;
+}
+
+// Index of the last instruction before `from` that writes reg, -1 if none
+int FindDefinition(llvm::ArrayRef<InstructionOperands> operands, int from, uint16_t reg) {
+    for (int i = from - 1; i >= 0; i--) {
+        if (WritesRegister(operands[i], reg)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Value of a register set to a constant address before `from`, as in
+// lea rdx, [rip+X] or mov rdx, imm
+bool ResolveConstant(llvm::ArrayRef<InstructionOperands> operands, int from, uint16_t reg, uint64_t& value) {
+    const int def = FindDefinition(operands, from, reg);
+    if (def < 0) {
+        return false;
+    }
+    const auto& ops = operands[def];
+    if (ops.kind == Kind::Lea && ops.base == 0 && ops.index == 0) {
+        value = static_cast<uint64_t>(ops.displacement);
+        return true;
+    }
+    if (ops.kind == Kind::Mov && ops.has_immediate && !ops.has_memory) {
+        value = ops.immediate;
+        return true;
+    }
+    return false;
+}
+
+// Table address of [base + index*scale + disp], the base must be a constant
+bool ResolveTableAddress(llvm::ArrayRef<InstructionOperands> operands, int from,
+                         const InstructionOperands& load, uint64_t& address) {
+    uint64_t base = 0;
+    if (load.base != 0 && !ResolveConstant(operands, from, load.base, base)) {
+        return false;
+    }
+    address = base + static_cast<uint64_t>(load.displacement);
+    return true;
+}
+
+// Entry count from the bounds check on the index, following register copies
+// made between the check and the table load
+bool FindBound(llvm::ArrayRef<InstructionOperands> operands, int from, uint16_t index, size_t& count) {
+    for (int i = from - 1; i >= 0; i--) {
+        const auto& ops = operands[i];
+        if (ops.kind == Kind::Cmp && ops.reg_count == 1 && ops.regs[0] == index && ops.has_immediate) {
+            // The first conditional jump after the compare decides the bound
+            for (size_t j = i + 1; j < operands.size(); j++) {
+                if (operands[j].kind == Kind::JumpAbove) {
+                    count = ops.immediate + 1;
+                    return true;
+                }
+                if (operands[j].kind == Kind::JumpAboveOrEqual) {
+                    count = ops.immediate;
+                    return true;
+                }
+                if (operands[j].kind == Kind::CondJump) {
+                    return false;
+                }
+            }
+            return false;
+        }
+        if (!WritesRegister(ops, index)) {
+            continue;
+        }
+        const bool copy = (ops.kind == Kind::Mov || ops.kind == Kind::MovSignExtend || ops.kind == Kind::MovZeroExtend) &&
+                          ops.reg_count == 2 && !ops.has_memory;
+        if (!copy) {
+            return false;
+        }
+        index = ops.regs[1];
+    }
+    return false;
+}
+
+}  // namespace
+
+bool RecognizeJumpTable(llvm::ArrayRef<DecodedInstruction> instructions,
+                        llvm::ArrayRef<InstructionOperands> operands,
+                        JumpTable& table) {
+    if (instructions.empty() || instructions.size() != operands.size() || !IsIndirectJump(instructions.back())) {
+        return false;
+    }
+    const int jump = static_cast<int>(instructions.size()) - 1;
+    const auto& jump_ops = operands[jump];
+    if (jump_ops.kind != Kind::Jump) {
+        return false;
+    }
+
+    table = JumpTable();
+    table.jump_address = instructions.back().address;
+
+    int load = jump;
+    InstructionOperands load_ops = jump_ops;
+    if (!jump_ops.has_memory) {
+        // jmp reg, optionally after add reg, base for relative entries
+        if (jump_ops.reg_count != 1) {
+            return false;
+        }
+        const uint16_t target = jump_ops.regs[0];
+        load = FindDefinition(operands, jump, target);
+        if (load < 0) {
+            return false;
+        }
+        if (operands[load].kind == Kind::Add && operands[load].reg_count == 2) {
+            if (!ResolveConstant(operands, load, operands[load].regs[1], table.entry_base)) {
+                return false;
+            }
+            load = FindDefinition(operands, load, target);
+            if (load < 0) {
+                return false;
+            }
+        }
+        load_ops = operands[load];
+        if (load_ops.kind != Kind::Mov && load_ops.kind != Kind::MovSignExtend) {
+            return false;
+        }
+    }
+
+    // The load itself: [base + index*size + disp]
+    if (!load_ops.has_memory || load_ops.index == 0 || load_ops.scale != load_ops.memory_size) {
+        return false;
+    }
+    table.entry_size = load_ops.memory_size;
+    table.signed_entries = load_ops.kind == Kind::MovSignExtend;
+    const bool absolute = table.entry_size == 8 && table.entry_base == 0;
+    const bool relative = table.entry_size == 4 && table.entry_base != 0;
+    if (!absolute && !relative) {
+        return false;
+    }
+    if (!ResolveTableAddress(operands, load, load_ops, table.table_address)) {
+        return false;
+    }
+    if (!FindBound(operands, load, load_ops.index, table.entry_count) ||
+        table.entry_count == 0 || table.entry_count > kMaxJumpTableEntries) {
+        return false;
+    }
+
+    VLOG(1) << "Jump table at 0x" << std::hex << table.table_address << " for jmp at 0x" << table.jump_address
+            << ", " << std::dec << table.entry_count << " entries of " << static_cast<int>(table.entry_size) << " bytes";
+    return true;
+}
+
+bool RecognizeJumpTable(const XEDDisassembler& disasm,
+                        llvm::ArrayRef<DecodedInstruction> instructions,
+                        JumpTable& table) {
+    if (instructions.empty() || !IsIndirectJump(instructions.back())) {
+        return false;
+    }
+    std::vector<InstructionOperands> operands(instructions.size());
+    for (size_t i = 0; i < instructions.size(); i++) {
+        if (!disasm.DecodeOperands(instructions[i], operands[i])) {
+            return false;
+        }
+    }
+    return RecognizeJumpTable(instructions, operands, table);
+}
+
+bool ReadJumpTable(JumpTable& table,
+                   const DataReader& read_data,
+                   const std::function<bool(uint64_t)>& is_code) {
+    std::vector<uint8_t> entries(table.entry_count * table.entry_size);
+    if (!read_data(table.table_address, entries.data(), entries.size())) {
+        LOG(WARNING) << "Jump table at 0x" << std::hex << table.table_address << " is not in the dump";
+        return false;
+    }
+
+    std::unordered_set<uint64_t> seen;
+    table.targets.clear();
+    for (size_t i = 0; i < table.entry_count; i++) {
+        uint64_t target = 0;
+        if (table.entry_size == 8) {
+            std::memcpy(&target, entries.data() + i * 8, 8);
+        } else {
+            uint32_t entry = 0;
+            std::memcpy(&entry, entries.data() + i * 4, 4);
+            const uint64_t offset = table.signed_entries ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(entry)))
+                                                         : entry;
+            target = table.entry_base + offset;
+        }
+        if (!is_code(target)) {
+            VLOG(1) << "Jump table entry " << std::dec << i << " at 0x" << std::hex << table.table_address
+                    << " is not code: 0x" << target;
+            continue;
+        }
+        if (seen.insert(target).second) {
+            table.targets.push_back(target);
+        }
+    }
+    return !table.targets.empty();
+}
+
+}  // namespace Discovery
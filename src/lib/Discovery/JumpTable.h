@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Disasm/DecodedInstruction.h"
+#include "Disasm/InstructionOperands.h"
+#include "Disasm/XEDDisassembler.h"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Discovery {
+
+// Tables larger than this are assumed to be a misrecognized bound
+constexpr size_t kMaxJumpTableEntries = 1024;
+
+// Data bytes from the dump, false unless all of them could be read
+using DataReader = std::function<bool(uint64_t address, uint8_t* buffer, size_t size)>;
+
+// Switch dispatch through a bounded table: target = entry_base + table[index]
+// for index in [0, entry_count). Covers absolute 8-byte tables as well as the
+// 4-byte image- or table-relative entries compilers emit for x64.
+struct JumpTable {
+    uint64_t jump_address = 0;
+    uint64_t table_address = 0;
+    uint8_t entry_size = 0;
+    bool signed_entries = false;
+    uint64_t entry_base = 0;
+    size_t entry_count = 0;
+
+    // Unique targets in table order, filled by ReadJumpTable
+    std::vector<uint64_t> targets;
+};
+
+// Recognize the table dispatch at the end of an instruction window. The
+// window runs up to the indirect jmp and should include the block holding the
+// bounds check, which is usually the predecessor ending in ja/jae. Works on
+// the instructions alone, the table is not read.
+bool RecognizeJumpTable(llvm::ArrayRef<DecodedInstruction> instructions,
+                        llvm::ArrayRef<InstructionOperands> operands,
+                        JumpTable& table);
+
+// Same, decoding the operands first
+bool RecognizeJumpTable(const XEDDisassembler& disasm,
+                        llvm::ArrayRef<DecodedInstruction> instructions,
+                        JumpTable& table);
+
+// Read the entries and fill `targets`, keeping those `is_code` accepts.
+// False if the table can't be read or yields no target.
+bool ReadJumpTable(JumpTable& table,
+                   const DataReader& read_data,
+                   const std::function<bool(uint64_t)>& is_code);
+
+// Last instruction is a jmp through a register or memory
+inline bool IsIndirectJump(const DecodedInstruction& inst) {
+    return inst.IsBranch() && !inst.IsCondBranch() && !inst.HasTarget();
+}
+
+}  // namespace Discovery
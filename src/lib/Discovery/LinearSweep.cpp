@@ -0,0 +1,270 @@
+#include "LinearSweep.h"
+
+#include "Discovery/StaticDiscovery.h"
+#include "Discovery/ThreadPool.h"
+#include "Disasm/XEDDisassembler.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace Discovery {
+
+namespace {
+
+// Compilers pad between functions with int3, a start is not marked in padding
+constexpr uint8_t kPaddingByte = 0xcc;
+
+// Offsets visited by a shard scan
+constexpr uint8_t kBoundary = 1;
+constexpr uint8_t kSkipped = 2;
+
+}  // namespace
+
+void BlockStartBitmap::AddRegion(uint64_t address, size_t size) {
+    Region region{address, size, std::unique_ptr<std::atomic<uint64_t>[]>(new std::atomic<uint64_t>[(size + 63) / 64]())};
+    const auto it = std::upper_bound(regions.begin(), regions.end(), address,
+                                     [](uint64_t value, const Region& item) { return value < item.address; });
+    regions.insert(it, std::move(region));
+}
+
+const BlockStartBitmap::Region* BlockStartBitmap::Find(uint64_t address) const {
+    auto it = std::upper_bound(regions.begin(), regions.end(), address,
+                               [](uint64_t value, const Region& item) { return value < item.address; });
+    if (it == regions.begin()) {
+        return nullptr;
+    }
+    --it;
+    return address - it->address < it->size ? &*it : nullptr;
+}
+
+bool BlockStartBitmap::Set(uint64_t address) {
+    const auto* region = Find(address);
+    if (!region) {
+        return false;
+    }
+    const uint64_t offset = address - region->address;
+    region->words[offset / 64].fetch_or(1ull << (offset % 64), std::memory_order_relaxed);
+    return true;
+}
+
+bool BlockStartBitmap::Test(uint64_t address) const {
+    const auto* region = Find(address);
+    if (!region) {
+        return false;
+    }
+    const uint64_t offset = address - region->address;
+    return region->words[offset / 64].load(std::memory_order_relaxed) & (1ull << (offset % 64));
+}
+
+size_t BlockStartBitmap::Count() const {
+    size_t count = 0;
+    for (const auto& region : regions) {
+        for (size_t i = 0; i < (region.size + 63) / 64; i++) {
+            count += __builtin_popcountll(region.words[i].load(std::memory_order_relaxed));
+        }
+    }
+    return count;
+}
+
+std::vector<uint64_t> BlockStartBitmap::GetBlockStarts(uint64_t start, uint64_t end) const {
+    std::vector<uint64_t> result;
+    for (const auto& region : regions) {
+        const uint64_t region_end = region.address + region.size;
+        if (region_end <= start || region.address >= end) {
+            continue;
+        }
+        const uint64_t first = std::max(start, region.address) - region.address;
+        const uint64_t last = std::min(end, region_end) - region.address;
+        for (size_t i = first / 64; i < (last + 63) / 64; i++) {
+            uint64_t word = region.words[i].load(std::memory_order_relaxed);
+            while (word) {
+                const uint64_t offset = i * 64 + __builtin_ctzll(word);
+                word &= word - 1;
+                if (offset >= first && offset < last) {
+                    result.push_back(region.address + offset);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+LinearSweep::LinearSweep(DecodeCache& cache_,
+                         size_t threads_,
+                         size_t shard_size_,
+                         size_t max_block_instructions_)
+    : cache(cache_)
+    , threads(threads_)
+    , shard_size(shard_size_)
+    , max_block_instructions(max_block_instructions_) {}
+
+void LinearSweep::Run(llvm::ArrayRef<CodeRegion> regions) {
+    size_t total = 0;
+    for (const auto& region : regions) {
+        block_starts.AddRegion(region.address, region.bytes.size());
+        total += region.bytes.size();
+    }
+    LOG(INFO) << "Sweeping " << std::dec << regions.size() << " executable regions, 0x" << std::hex << total << " bytes";
+
+    ThreadPool pool(threads);
+
+    // Shards are scanned in parallel from their nominal start
+    std::vector<std::vector<ShardScan>> scans(regions.size());
+    for (size_t i = 0; i < regions.size(); i++) {
+        const auto& region = regions[i];
+        for (size_t begin = 0; begin < region.bytes.size(); begin += shard_size) {
+            auto& scan = scans[i].emplace_back();
+            scan.begin = begin;
+            scan.end = std::min(begin + shard_size, region.bytes.size());
+        }
+        for (auto& scan : scans[i]) {
+            pool.Submit([this, &region, &scan] { scan.exit = ScanBoundaries(region, scan.begin, nullptr, scan); });
+        }
+    }
+    pool.Wait();
+
+    // Each shard really starts where the previous one's last instruction
+    // ends. Realigning walks only until the nominal scan is met, x86 code
+    // resynchronizes within a few instructions
+    size_t realigned = 0;
+    for (size_t i = 0; i < regions.size(); i++) {
+        size_t start = 0;
+        for (auto& scan : scans[i]) {
+            if (start != scan.begin) {
+                AlignShard(regions[i], start, scan);
+                realigned++;
+            }
+            start = scan.exit;
+        }
+    }
+
+    // Every start has to be known before blocks are cut, targets cross shards
+    for (size_t i = 0; i < regions.size(); i++) {
+        for (const auto& scan : scans[i]) {
+            pool.Submit([this, &region = regions[i], &scan] { ApplyShard(region, scan); });
+        }
+    }
+    pool.Wait();
+    VLOG(1) << "Realigned " << std::dec << realigned << " shards to the previous instruction end";
+    scans.clear();
+
+    for (const auto& region : regions) {
+        for (size_t begin = 0; begin < region.bytes.size(); begin += shard_size) {
+            const size_t end = std::min(begin + shard_size, region.bytes.size());
+            pool.Submit([this, &region, begin, end] { DecodeBlocks(region, begin, end); });
+        }
+    }
+    pool.Wait();
+
+    LOG(INFO) << "Sweep found " << std::dec << boundaries << " instructions, " << candidates
+              << " control flow candidates, " << block_starts.Count() << " block starts, "
+              << blocks_decoded << " blocks decoded";
+}
+
+// Walk the instruction boundaries from offset to the shard end and fully
+// decode the control flow candidates. The last instruction may run past the
+// shard end, the offset after it is returned. A nominal scan marks every
+// offset it visits, kBoundary for an instruction and kSkipped for a byte
+// that decodes to nothing. Realigning stops at the first offset the aligned
+// scan visited, the walk from there on is the same.
+size_t LinearSweep::ScanBoundaries(const CodeRegion& region, size_t offset, const ShardScan* aligned,
+                                   ShardScan& scan) const {
+    const auto& disasm = XEDDisassembler::Get();
+    const auto& bytes = region.bytes;
+    if (!aligned) {
+        scan.marks.assign(scan.end - scan.begin, 0);
+    }
+
+    while (offset < scan.end) {
+        if (aligned && aligned->IsVisited(offset)) {
+            break;
+        }
+        const auto length = disasm.DecodeLength(bytes.data() + offset, bytes.size() - offset);
+        if (length.length == 0) {
+            if (!aligned) {
+                scan.marks[offset - scan.begin] = kSkipped;
+            }
+            offset++;
+            continue;
+        }
+        if (!aligned) {
+            scan.marks[offset - scan.begin] = kBoundary;
+        }
+        scan.boundaries++;
+
+        if (length.IsControlFlowCandidate()) {
+            const auto inst = disasm.DecodeInstruction(bytes.data() + offset, bytes.size() - offset,
+                                                       region.address + offset);
+            if (inst.length != 0) {
+                scan.candidates.push_back(inst);
+            }
+        }
+        offset += length.length;
+    }
+    return offset;
+}
+
+// Replace the part of the nominal scan before the shard's real start
+void LinearSweep::AlignShard(const CodeRegion& region, size_t start, ShardScan& scan) const {
+    ShardScan head;
+    head.begin = scan.begin;
+    head.end = scan.end;
+    const size_t met = ScanBoundaries(region, start, &scan, head);
+
+    // Keep what the nominal scan found from the meeting offset on
+    const uint64_t met_address = region.address + met;
+    const auto kept = std::find_if(scan.candidates.begin(), scan.candidates.end(),
+                                   [met_address](const DecodedInstruction& inst) { return inst.address >= met_address; });
+    head.candidates.insert(head.candidates.end(), kept, scan.candidates.end());
+    for (size_t offset = met; offset < scan.end; offset++) {
+        head.boundaries += scan.marks[offset - scan.begin] == kBoundary;
+    }
+    head.exit = met < scan.end ? scan.exit : met;
+
+    scan.candidates = std::move(head.candidates);
+    scan.boundaries = head.boundaries;
+    scan.exit = head.exit;
+}
+
+void LinearSweep::ApplyShard(const CodeRegion& region, const ShardScan& scan) {
+    const auto& bytes = region.bytes;
+    if (scan.begin == 0) {
+        block_starts.Set(region.address);
+    }
+    for (const auto& inst : scan.candidates) {
+        cache.Insert(inst);
+        if (inst.HasTarget()) {
+            block_starts.Set(inst.target);
+        }
+        const size_t next = inst.address - region.address + inst.length;
+        if (inst.IsTerminator() && next < bytes.size() && bytes[next] != kPaddingByte) {
+            block_starts.Set(region.address + next);
+        }
+    }
+    boundaries += scan.boundaries;
+    candidates += scan.candidates.size();
+}
+
+void LinearSweep::DecodeBlocks(const CodeRegion& region, size_t begin, size_t end) {
+    const auto& disasm = XEDDisassembler::Get();
+    const auto read_code = [&region](uint64_t address, size_t size) -> llvm::ArrayRef<uint8_t> {
+        const uint64_t offset = address - region.address;
+        if (offset >= region.bytes.size()) {
+            return {};
+        }
+        return region.bytes.slice(offset, std::min<size_t>(size, region.bytes.size() - offset));
+    };
+
+    size_t local_blocks = 0;
+    std::vector<DecodedInstruction> instructions;
+    for (const auto address : block_starts.GetBlockStarts(region.address + begin, region.address + end)) {
+        instructions.clear();
+        if (DecodeBlock(disasm, cache, read_code, address, max_block_instructions, instructions)) {
+            local_blocks++;
+        }
+    }
+    blocks_decoded += local_blocks;
+}
+
+}  // namespace Discovery
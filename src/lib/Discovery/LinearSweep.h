@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Disasm/DecodeCache.h"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Discovery {
+
+// Executable bytes to sweep, owned by the caller
+struct CodeRegion {
+    uint64_t address;
+    llvm::ArrayRef<uint8_t> bytes;
+};
+
+// One bit per byte of a fixed set of regions. Bits can be set concurrently,
+// the regions must all be added before that.
+class BlockStartBitmap {
+public:
+    void AddRegion(uint64_t address, size_t size);
+
+    // False if the address is outside every region
+    bool Set(uint64_t address);
+    bool Test(uint64_t address) const;
+
+    size_t Count() const;
+
+    // Set addresses in [start, end), ascending
+    std::vector<uint64_t> GetBlockStarts(uint64_t start = 0, uint64_t end = UINT64_MAX) const;
+
+private:
+    struct Region {
+        uint64_t address;
+        size_t size;
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+    };
+
+    // Sorted by address
+    std::vector<Region> regions;
+
+    const Region* Find(uint64_t address) const;
+};
+
+// Linear sweep over executable regions, sharded across a thread pool. A
+// length-only pass walks the instruction boundaries and fully decodes just
+// the control flow candidates, which gives the block starts: region starts,
+// direct targets and the instructions after terminators. Every shard is
+// scanned from its nominal start and then realigned to begin where the
+// previous shard's last instruction ends, so the walk over a region is the
+// same as a single one from its start. A second pass then decodes every
+// block from its start into the shared decode cache.
+class LinearSweep {
+public:
+    LinearSweep(DecodeCache& cache,
+                size_t threads = 0,
+                size_t shard_size = 0x10000,
+                size_t max_block_instructions = 32);
+
+    void Run(llvm::ArrayRef<CodeRegion> regions);
+
+    const BlockStartBitmap& GetBlockStarts() const { return block_starts; }
+    size_t GetBoundaryCount() const { return boundaries; }
+    size_t GetCandidateCount() const { return candidates; }
+    size_t GetBlocksDecoded() const { return blocks_decoded; }
+
+private:
+    DecodeCache& cache;
+    size_t threads;
+    size_t shard_size;
+    size_t max_block_instructions;
+    BlockStartBitmap block_starts;
+
+    std::atomic<size_t> boundaries{0};
+    std::atomic<size_t> candidates{0};
+    std::atomic<size_t> blocks_decoded{0};
+
+    // Boundary pass results of one shard, applied once the shard is aligned
+    struct ShardScan {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t exit = 0;                            // Where the last instruction ends
+        std::vector<uint8_t> marks;                 // Per byte from begin, see ScanBoundaries
+        std::vector<DecodedInstruction> candidates; // Ascending
+        size_t boundaries = 0;
+
+        bool IsVisited(size_t offset) const {
+            return offset >= begin && offset < end && marks[offset - begin] != 0;
+        }
+    };
+
+    size_t ScanBoundaries(const CodeRegion& region, size_t offset, const ShardScan* aligned, ShardScan& scan) const;
+    void AlignShard(const CodeRegion& region, size_t start, ShardScan& scan) const;
+    void ApplyShard(const CodeRegion& region, const ShardScan& scan);
+    void DecodeBlocks(const CodeRegion& region, size_t begin, size_t end);
+};
+
+}  // namespace Discovery
@@ -0,0 +1,137 @@
+#include "StaticDiscovery.h"
+
+#include <glog/logging.h>
+
+namespace Discovery {
+
+bool DecodeBlock(const XEDDisassembler& disasm,
+                 DecodeCache& cache,
+                 const CodeReader& read_code,
+                 uint64_t address,
+                 size_t max_block_instructions,
+                 std::vector<DecodedInstruction>& instructions) {
+    uint64_t current = address;
+    while (instructions.size() < max_block_instructions) {
+        DecodedInstruction inst;
+        if (!cache.Lookup(current, inst)) {
+            const auto code = read_code(current, kMaxInstructionBytes);
+            if (code.empty()) {
+                break;
+            }
+            inst = disasm.DecodeInstruction(code.data(), code.size(), current);
+            if (inst.length == 0) {
+                break;
+            }
+            cache.Insert(inst);
+        }
+
+        instructions.push_back(inst);
+        if (inst.IsTerminator()) {
+            break;
+        }
+        current += inst.length;
+    }
+    return !instructions.empty();
+}
+
+void GetSuccessors(llvm::ArrayRef<DecodedInstruction> instructions,
+                   size_t max_block_instructions,
+                   std::vector<uint64_t>& successors) {
+    const auto& last = instructions.back();
+    const uint64_t fallthrough = last.GetNextAddress();
+
+    if (last.IsRet() || last.IsInt3()) {
+        return;
+    }
+    if ((last.IsBranch() || last.IsCall()) && last.HasTarget()) {
+        successors.push_back(last.target);
+    }
+    // Calls are assumed to return, blocks cut at the length limit continue
+    if (last.IsCondBranch() || last.IsCall() ||
+        (!last.IsBranch() && instructions.size() >= max_block_instructions)) {
+        successors.push_back(fallthrough);
+    }
+}
+
+StaticDiscovery::StaticDiscovery(DecodeCache& cache_,
+                                 CodeReader read_code_,
+                                 size_t max_blocks_,
+                                 size_t max_block_instructions_)
+    : cache(cache_)
+    , read_code(std::move(read_code_))
+    , max_blocks(max_blocks_)
+    , max_block_instructions(max_block_instructions_) {}
+
+std::vector<DiscoveredBlock> StaticDiscovery::Run(uint64_t start_address) {
+    LOG(INFO) << "Static discovery from 0x" << std::hex << start_address;
+
+    std::vector<DiscoveredBlock> blocks;
+    std::vector<uint64_t> worklist = {start_address};
+    std::unordered_set<uint64_t> visited;
+    std::vector<uint64_t> successors;
+
+    // Block index by address and the conditional branch block leading to a
+    // block, which holds the bounds check of a switch
+    std::unordered_map<uint64_t, size_t> block_index;
+    std::unordered_map<uint64_t, uint64_t> predecessors;
+
+    while (!worklist.empty()) {
+        const uint64_t address = worklist.back();
+        worklist.pop_back();
+        if (stop_addresses.count(address) || !visited.insert(address).second) {
+            continue;
+        }
+        if (blocks.size() >= max_blocks) {
+            truncated = true;
+            break;
+        }
+
+        DiscoveredBlock block{address, {}};
+        if (!DecodeBlock(disasm, cache, read_code, address, max_block_instructions, block.instructions)) {
+            VLOG(1) << "No code at 0x" << std::hex << address;
+            blocks_failed++;
+            continue;
+        }
+
+        successors.clear();
+        GetSuccessors(block.instructions, max_block_instructions, successors);
+        if (block.instructions.back().IsCondBranch()) {
+            for (const auto successor : successors) {
+                predecessors.emplace(successor, address);
+            }
+        }
+        if (read_data && IsIndirectJump(block.instructions.back())) {
+            std::vector<DecodedInstruction> window;
+            const auto predecessor = predecessors.find(address);
+            if (predecessor != predecessors.end()) {
+                const auto& previous = blocks[block_index.at(predecessor->second)].instructions;
+                window.assign(previous.begin(), previous.end());
+            }
+            window.insert(window.end(), block.instructions.begin(), block.instructions.end());
+
+            JumpTable table;
+            const auto is_code = [this](uint64_t target) { return !read_code(target, 1).empty(); };
+            if (RecognizeJumpTable(disasm, window, table) && ReadJumpTable(table, read_data, is_code)) {
+                VLOG(1) << "Jump table at 0x" << std::hex << table.jump_address << " has " << std::dec
+                        << table.targets.size() << " targets";
+                successors.insert(successors.end(), table.targets.begin(), table.targets.end());
+                jump_tables++;
+            }
+        }
+        // Pushed in reverse so the branch target is walked before the fallthrough
+        for (auto it = successors.rbegin(); it != successors.rend(); ++it) {
+            if (!visited.count(*it)) {
+                worklist.push_back(*it);
+            }
+        }
+        block_index.emplace(address, blocks.size());
+        blocks.push_back(std::move(block));
+    }
+
+    LOG(INFO) << "Static discovery found " << std::dec << blocks.size() << " blocks, "
+              << blocks_failed << " without code, " << jump_tables << " jump tables"
+              << (truncated ? ", stopped at the block limit" : "");
+    return blocks;
+}
+
+}  // namespace Discovery
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Discovery/JumpTable.h"
+#include "Disasm/DecodeCache.h"
+#include "Disasm/XEDDisassembler.h"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Discovery {
+
+// Code bytes at an address, empty if the address can't be executed
+using CodeReader = std::function<llvm::ArrayRef<uint8_t>(uint64_t address, size_t size)>;
+
+// Decode from address up to the first terminator, going through the cache
+bool DecodeBlock(const XEDDisassembler& disasm,
+                 DecodeCache& cache,
+                 const CodeReader& read_code,
+                 uint64_t address,
+                 size_t max_block_instructions,
+                 std::vector<DecodedInstruction>& instructions);
+
+// Statically known successors of a decoded block: direct branch and call
+// targets, plus the fallthrough of conditional branches, calls and blocks
+// cut at the length limit
+void GetSuccessors(llvm::ArrayRef<DecodedInstruction> instructions,
+                   size_t max_block_instructions,
+                   std::vector<uint64_t>& successors);
+
+struct DiscoveredBlock {
+    uint64_t address;
+    std::vector<DecodedInstruction> instructions;
+};
+
+// Recursive descent over direct control flow from a start address, run
+// before the first execution so the initial module already holds every
+// block reachable without resolving an indirect branch. Only decodes, the
+// blocks are handed back to be lifted in one batch.
+class StaticDiscovery {
+public:
+    StaticDiscovery(DecodeCache& cache,
+                    CodeReader read_code,
+                    size_t max_blocks,
+                    size_t max_block_instructions = 32);
+
+    // Addresses that are never entered, e.g. the stop address
+    void AddStopAddress(uint64_t address) { stop_addresses.insert(address); }
+
+    // Enables jump table recovery, the tables are read through this
+    void SetDataReader(DataReader reader) { read_data = std::move(reader); }
+
+    // Blocks in discovery order, the start block first
+    std::vector<DiscoveredBlock> Run(uint64_t start_address);
+
+    size_t GetBlocksFailed() const { return blocks_failed; }
+    size_t GetJumpTableCount() const { return jump_tables; }
+    bool IsTruncated() const { return truncated; }
+
+private:
+    DecodeCache& cache;
+    CodeReader read_code;
+    size_t max_blocks;
+    size_t max_block_instructions;
+    const XEDDisassembler& disasm = XEDDisassembler::Get();
+    std::unordered_set<uint64_t> stop_addresses;
+    DataReader read_data;
+
+    size_t blocks_failed = 0;
+    size_t jump_tables = 0;
+    bool truncated = false;
+};
+
+}  // namespace Discovery
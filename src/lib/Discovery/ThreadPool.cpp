@@ -0,0 +1,68 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace Discovery {
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+    task_ready.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && active == 0; });
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+            // Pending tasks still run when the pool is stopping
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+            active++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+            if (tasks.empty() && active == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+}
+
+}  // namespace Discovery
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Discovery {
+
+// Fixed set of worker threads pulling tasks from a shared queue
+class ThreadPool {
+public:
+    // 0 uses one thread per hardware thread
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    // Block until the queue is drained and no task is running
+    void Wait();
+
+    size_t GetThreadCount() const { return workers.size(); }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable task_ready;
+    std::condition_variable idle;
+    size_t active = 0;
+    bool stopping = false;
+
+    void WorkerLoop();
+};
+
+}  // namespace Discovery
@@ -78,6 +78,8 @@ bool JITEngine::Initialize(std::unique_ptr<llvm::Module> module) {
         {"__rt_write_memory8", reinterpret_cast<void*>(Runtime::__rt_write_memory8)},
 
         {"__remill_async_hyper_call", reinterpret_cast<void*>(Runtime::__remill_async_hyper_call)},
+        {"__rt_memory_fault", reinterpret_cast<void*>(Runtime::__rt_memory_fault)},
+        {"__rt_block_fault", reinterpret_cast<void*>(Runtime::__rt_block_fault)},
 
         {"LogMessage", reinterpret_cast<void*>(Runtime::LogMessage)},
         {"RuntimeCallback", reinterpret_cast<void*>(Runtime::RuntimeCallback)},
@@ -114,6 +116,14 @@ bool JITEngine::Initialize(std::unique_ptr<llvm::Module> module) {
     return true;
 }
 
+uint64_t JITEngine::GetGlobalAddress(const std::string& name) {
+    if (!ExecutionEngine) {
+        LOG(ERROR) << "Execution engine not initialized";
+        return 0;
+    }
+    return ExecutionEngine->getGlobalValueAddress(name);
+}
+
 bool JITEngine::ExecuteFunction(const std::string& name, uintptr_t* result) {
     if (!ExecutionEngine) {
         LOG(ERROR) << "Execution engine not initialized";
@@ -17,6 +17,9 @@ public:
     // Execute a specific function from the module
     bool ExecuteFunction(const std::string& name, uintptr_t* result = nullptr);
 
+    // Address of a global variable in the JIT memory, 0 if not found
+    uint64_t GetGlobalAddress(const std::string& name);
+
 private:
     std::unique_ptr<llvm::ExecutionEngine> ExecutionEngine;
 }; 
\ No newline at end of file
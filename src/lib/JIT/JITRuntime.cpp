@@ -14,6 +14,9 @@ namespace Runtime {
 std::vector<uint64_t> MissingBlockTracker::missing_blocks;
 std::unordered_set<uint64_t> MissingBlockTracker::ignored_addresses;
 std::vector<std::pair<uint64_t, uint8_t>> MissingMemoryTracker::missing_memory;
+std::unordered_set<uint64_t> MemoryFaultTracker::fault_pages;
+size_t MemoryFaultTracker::fault_count = 0;
+std::unordered_set<uint64_t> BlockFaultTracker::fault_blocks;
 
 namespace {
     RuntimeCallbackFn g_runtimeCallback = nullptr;
@@ -51,6 +54,17 @@ void* __remill_async_hyper_call(void* state, uint64_t pc, void* memory) {
     return memory;
 }
 
+void __rt_memory_fault(uint64_t addr) {
+    VLOG(1) << "JRT: Read from unmapped memory at address: 0x" << std::hex << addr;
+    MemoryFaultTracker::AddFault(addr);
+}
+
+void* __rt_block_fault(void* state, uint64_t pc, void* memory) {
+    VLOG(1) << "JRT: Branch to non-executable memory at PC: 0x" << std::hex << pc;
+    BlockFaultTracker::AddFault(pc);
+    return memory;
+}
+
 uint64_t __rt_read_memory64(void *memory, intptr_t addr) {
     VLOG(1) << "JRT: Reading memory at address: 0x" << std::hex << addr;
     MissingMemoryTracker::AddMissingMemory(addr, 8);
@@ -180,6 +194,97 @@ void MissingMemoryTracker::ClearMissingMemory() {
     missing_memory.clear();
 }
 
+void MemoryFaultTracker::AddFault(uint64_t addr) {
+    fault_pages.insert(addr & ~(PREBUILT_MEMORY_CELL_SIZE - 1));
+    fault_count++;
+}
+
+const std::unordered_set<uint64_t>& MemoryFaultTracker::GetFaultPages() {
+    return fault_pages;
+}
+
+size_t MemoryFaultTracker::GetFaultCount() {
+    return fault_count;
+}
+
+void MemoryFaultTracker::ClearFaults() {
+    fault_pages.clear();
+    fault_count = 0;
+}
+
+void BlockFaultTracker::AddFault(uint64_t pc) {
+    fault_blocks.insert(pc);
+}
+
+const std::unordered_set<uint64_t>& BlockFaultTracker::GetFaultBlocks() {
+    return fault_blocks;
+}
+
+void BlockFaultTracker::ClearFaults() {
+    fault_blocks.clear();
+}
+
+MemoryReadAhead::MemoryReadAhead(size_t max_window_)
+    : max_window(max_window_), window(std::min<size_t>(1, max_window_)) {}
+
+std::vector<uint64_t> MemoryReadAhead::OnMiss(uint64_t page_addr) {
+    const uint64_t page_size = PREBUILT_MEMORY_CELL_SIZE;
+
+    // A miss right past the pages covered last time means a sequential scan
+    int direction = 1;
+    if (has_miss && page_addr == covered_high + page_size) {
+        window = std::min(std::max<size_t>(window * 2, 1), max_window);
+    } else if (has_miss && page_addr + page_size == covered_low) {
+        window = std::min(std::max<size_t>(window * 2, 1), max_window);
+        direction = -1;
+    }
+    has_miss = true;
+    covered_low = page_addr;
+    covered_high = page_addr;
+
+    std::vector<uint64_t> pages;
+    for (size_t i = 1; i <= window; i++) {
+        if (direction < 0 && page_addr < i * page_size) {
+            break;
+        }
+        pages.push_back(direction > 0 ? page_addr + i * page_size : page_addr - i * page_size);
+    }
+    VLOG(1) << "Read-ahead window " << window << " for page 0x" << std::hex << page_addr;
+    return pages;
+}
+
+void MemoryReadAhead::AddPrefetched(uint64_t page_addr) {
+    covered_low = std::min(covered_low, page_addr);
+    covered_high = std::max(covered_high, page_addr);
+    pending.push_back(page_addr);
+    prefetched++;
+}
+
+void MemoryReadAhead::OnExecuted(const std::unordered_set<uint64_t>& accessed_pages) {
+    if (pending.empty()) {
+        return;
+    }
+
+    size_t used = 0;
+    for (const auto page_addr : pending) {
+        used += accessed_pages.count(page_addr);
+    }
+    const size_t unused = pending.size() - used;
+    hits += used;
+    wasted += unused;
+    pending.clear();
+
+    if (unused > used) {
+        window /= 2;
+    }
+    VLOG(1) << "Read-ahead: " << used << " prefetched pages used, " << unused << " unused, window " << window;
+}
+
+void MemoryReadAhead::Report() const {
+    LOG(INFO) << "Read-ahead: " << prefetched << " pages prefetched, " << hits << " hits, "
+              << wasted << " wasted, final window " << window;
+}
+
 void RuntimeExit(uint32_t code) {
     LOG(INFO) << "JRT: exit called with code: " << code;
     exit(code);
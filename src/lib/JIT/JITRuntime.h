@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <unordered_set>
+#include <cstddef>
 
 namespace Runtime {
 
@@ -31,6 +32,65 @@ private:
     static std::vector<std::pair<uint64_t, uint8_t>> missing_memory;
 };
 
+// Reads that hit a page known to be absent from the memory source. They are
+// served from a zero page instead of being reported as missing memory.
+class MemoryFaultTracker {
+public:
+    static void AddFault(uint64_t addr);
+    static const std::unordered_set<uint64_t>& GetFaultPages();
+    static size_t GetFaultCount();
+    static void ClearFaults();
+
+private:
+    static std::unordered_set<uint64_t> fault_pages;
+    static size_t fault_count;
+};
+
+// Branches into memory known not to be executable. The missing block handler
+// sends them here instead of reporting them as missing blocks again.
+class BlockFaultTracker {
+public:
+    static void AddFault(uint64_t pc);
+    static const std::unordered_set<uint64_t>& GetFaultBlocks();
+    static void ClearFaults();
+
+private:
+    static std::unordered_set<uint64_t> fault_blocks;
+};
+
+// Read-ahead policy for missing memory pages. Each miss prefetches a window
+// of neighbouring pages, the window grows while misses keep running past the
+// previous window and shrinks when prefetched pages are not read.
+class MemoryReadAhead {
+public:
+    explicit MemoryReadAhead(size_t max_window = 8);
+
+    // Pages to prefetch for a missing page, nearest first. The caller drops
+    // the ones it can't provide and reports the rest with AddPrefetched
+    std::vector<uint64_t> OnMiss(uint64_t page_addr);
+    void AddPrefetched(uint64_t page_addr);
+
+    // Pages read during the last execution, resolves pending prefetches
+    void OnExecuted(const std::unordered_set<uint64_t>& accessed_pages);
+
+    size_t GetWindow() const { return window; }
+    size_t GetPrefetched() const { return prefetched; }
+    size_t GetHits() const { return hits; }
+    size_t GetWasted() const { return wasted; }
+    void Report() const;
+
+private:
+    size_t max_window;
+    size_t window = 1;
+    bool has_miss = false;
+    uint64_t covered_low = 0;
+    uint64_t covered_high = 0;
+    std::vector<uint64_t> pending;
+    size_t prefetched = 0;
+    size_t hits = 0;
+    size_t wasted = 0;
+};
+
 // Add this before the extern "C" block
 using RuntimeCallbackFn = void(*)(void* state, uint64_t* pc, void** memory);
 
@@ -51,6 +111,8 @@ extern "C" {
     void* __rt_write_memory8(void *memory, intptr_t addr, uint8_t val);
 
     void* __remill_async_hyper_call(void* state, uint64_t pc, void* memory);
+    void __rt_memory_fault(uint64_t addr);
+    void* __rt_block_fault(void* state, uint64_t pc, void* memory);
     // Variadic logging function
     void LogMessage(const char* format, ...);
     void RuntimeCallback(void* state, uint64_t* pc, void** memory);
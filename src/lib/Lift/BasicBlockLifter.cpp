@@ -1,4 +1,5 @@
 #include "BasicBlockLifter.h"
+#include "ByteSourceTraceManager.h"
 
 #include <remill/OS/OS.h>
 #include <remill/BC/Util.h>
@@ -8,105 +9,18 @@
 #include <remill/BC/TraceLifter.h>
 #include <remill/BC/Optimizer.h>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 #include <glog/logging.h>
 #include <llvm/Linker/Linker.h>
 
-using Memory = std::map<uint64_t, uint8_t>;
+BasicBlockLifter::BasicBlockLifter(LiftingContext &lifting) : lifting(&lifting) {}
 
-class SimpleTraceManager : public remill::TraceManager
-{
-public:
-    virtual ~SimpleTraceManager(void) = default;
-
-    explicit SimpleTraceManager(Memory &memory_) : memory(memory_) {}
-
-protected:
-    // Called when we have lifted, i.e. defined the contents, of a new trace.
-    // The derived class is expected to do something useful with this.
-    void SetLiftedTraceDefinition(uint64_t addr,
-                                  llvm::Function *lifted_func) override
-    {
-        traces[addr] = lifted_func;
-    }
-
-    // Get a declaration for a lifted trace. The idea here is that a derived
-    // class might have additional global info available to them that lets
-    // them declare traces ahead of time. In order to distinguish between
-    // stuff we've lifted, and stuff we haven't lifted, we allow the lifter
-    // to access "defined" vs. "declared" traces.
-    //
-    // NOTE: This is permitted to return a function from an arbitrary module.
-    llvm::Function *GetLiftedTraceDeclaration(uint64_t addr) override
-    {
-        auto trace_it = traces.find(addr);
-        if (trace_it != traces.end())
-        {
-            return trace_it->second;
-        }
-        else
-        {
-            return nullptr;
-        }
-    }
-
-    // Get a definition for a lifted trace.
-    //
-    // NOTE: This is permitted to return a function from an arbitrary module.
-    llvm::Function *GetLiftedTraceDefinition(uint64_t addr) override
-    {
-        return GetLiftedTraceDeclaration(addr);
-    }
-
-    // Try to read an executable byte of memory. Returns `true` of the byte
-    // at address `addr` is executable and readable, and updates the byte
-    // pointed to by `byte` with the read value.
-    bool TryReadExecutableByte(uint64_t addr, uint8_t *byte) override
-    {
-        auto byte_it = memory.find(addr);
-        if (byte_it != memory.end())
-        {
-            *byte = byte_it->second;
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-
-public:
-    Memory &memory;
-    std::unordered_map<uint64_t, llvm::Function *> traces;
-};
-
-BasicBlockLifter::BasicBlockLifter(llvm::LLVMContext &context) : context(&context) {}
-
-bool BasicBlockLifter::VerifyIntrinsics() {
-    if (!intrinsics->error) {
-        LOG(ERROR) << "Missing critical intrinsic: __remill_error";
-        return false;
-    }
-    if (!intrinsics->jump) {
-        LOG(ERROR) << "Missing critical intrinsic: __remill_jump";
-        return false;
-    }
-    if (!intrinsics->function_call) {
-        LOG(ERROR) << "Missing critical intrinsic: __remill_function_call";
-        return false;
-    }
-    if (!intrinsics->function_return) {
-        LOG(ERROR) << "Missing critical intrinsic: __remill_function_return";
-        return false;
-    }
-    if (!intrinsics->missing_block) {
-        LOG(ERROR) << "Missing critical intrinsic: __remill_missing_block";
-        return false;
-    }
-    return true;
-}
+BasicBlockLifter::BasicBlockLifter(llvm::LLVMContext &context)
+    : owned_lifting(std::make_unique<LiftingContext>(context)), lifting(owned_lifting.get()) {}
 
 bool BasicBlockLifter::LiftBlock(
-    const std::vector<DecodedInstruction>& instructions,
+    llvm::ArrayRef<DecodedInstruction> instructions,
     uint64_t block_addr) {
     
     if (instructions.empty()) {
@@ -114,68 +28,62 @@ bool BasicBlockLifter::LiftBlock(
         return false;
     }
 
-    // Initialize architecture if not already done
-    if (!arch) {
-        VLOG(1) << "Creating architecture for windows/amd64";
-        arch = remill::Arch::Get(*context, "windows", "amd64");
-        if (!arch) {
-            LOG(ERROR) << "Failed to create architecture";
-            return false;
-        }
-    }
+    // Only the decoded bytes are readable, the lifter stops where they end
+    InstructionByteSource source(instructions);
+    return LiftTraces(source, block_addr, true);
+}
 
-    // Create a map of bytes for the instructions
-    std::map<uint64_t, uint8_t> memory;
-    for (const auto& inst : instructions) {
-        for (size_t i = 0; i < inst.bytes.size(); ++i) {
-            memory[inst.address + i] = inst.bytes[i];
-        }
-    }
+bool BasicBlockLifter::LiftTrace(ByteSource& source, uint64_t trace_addr) {
+    return LiftTraces(source, trace_addr, false);
+}
 
-    // Load architecture semantics into module
-    VLOG(1) << "Loading architecture semantics";
-    auto temp_module = remill::LoadArchSemantics(arch.get());
-    if (!temp_module) {
-        LOG(ERROR) << "Failed to create module";
+bool BasicBlockLifter::LiftTraces(ByteSource& source, uint64_t trace_addr, bool lift_callees) {
+    // Architecture and semantics are loaded once per lifting context
+    if (!lifting->Initialize()) {
         return false;
     }
 
-    // Initialize intrinsics if not already done
-    if (!intrinsics) {
-        VLOG(1) << "Initializing intrinsics table";
-        intrinsics = std::make_unique<remill::IntrinsicTable>(temp_module.get());
-        if (!VerifyIntrinsics()) {
-            LOG(ERROR) << "Failed to verify critical intrinsics";
-            return false;
-        }
-    }
-
-    SimpleTraceManager inst_manager(memory);
-    remill::TraceLifter inst_lifter(arch.get(), inst_manager);
+    ByteSourceTraceManager inst_manager(source, trace_addr, lift_callees);
+    remill::TraceLifter inst_lifter(lifting->GetArch(), inst_manager);
 
     // Lift the trace starting at our block address
-    VLOG(1) << "Lifting trace at address 0x" << std::hex << block_addr;
-    if (!inst_lifter.Lift(block_addr)) {
-        LOG(ERROR) << "Failed to lift trace at address 0x" << std::hex << block_addr;
+    VLOG(1) << "Lifting trace at address 0x" << std::hex << trace_addr;
+    if (!inst_lifter.Lift(trace_addr)) {
+        LOG(ERROR) << "Failed to lift trace at address 0x" << std::hex << trace_addr;
+        lifting->DiscardLifted();
         return false;
     }
 
+    // The traces were lifted into the shared semantics module, copy them out
+    // with only the semantics they call
+    std::vector<llvm::Function*> lifted_functions;
+    std::vector<std::pair<uint64_t, std::string>> trace_names;
+    for (const auto& lifted_entry : inst_manager.GetTraces()) {
+        lifted_functions.push_back(lifted_entry.second);
+        trace_names.emplace_back(lifted_entry.first, lifted_entry.second->getName().str());
+    }
+    auto temp_module = lifting->ExtractLifted(lifted_functions);
+    std::unordered_map<uint64_t, llvm::Function *> traces;
+    for (const auto& [address, name] : trace_names) {
+        traces[address] = temp_module->getFunction(name);
+    }
+
     // Optimize the lifted code
     remill::OptimizationGuide guide = {};
-    remill::OptimizeModule(arch, temp_module, inst_manager.traces, guide);
+    remill::OptimizeModule(lifting->GetArch(), temp_module.get(), traces, guide);
 
     // Create destination module if it doesn't exist
     if (!dest_module) {
         VLOG(1) << "Creating new destination module";
-        dest_module = std::make_unique<llvm::Module>("lifted_code", *context);
-        arch->PrepareModuleDataLayout(dest_module.get());
+        dest_module = std::make_unique<llvm::Module>("lifted_code", lifting->GetContext());
+        lifting->GetArch()->PrepareModuleDataLayout(dest_module.get());
     }
 
     // Move the lifted functions into the destination module
-    for (auto &lifted_entry : inst_manager.traces) {
+    for (auto &lifted_entry : traces) {
         LOG(INFO) << "Moving function '" << lifted_entry.second->getName().str() << "' into destination module";
         remill::MoveFunctionIntoModule(lifted_entry.second, dest_module.get());
     }
 
     return true;
-}
\ No newline at end of file
+}
@@ -1,25 +1,34 @@
 #pragma once
 
 #include <remill/Arch/Arch.h>
+#include "Disasm/ByteSource.h"
 #include "Disasm/DecodedInstruction.h"
+#include "Lift/LiftingContext.h"
 
 // Class to handle lifting to LLVM IR using Remill
 class BasicBlockLifter {
 public:
+    // Lifts with the session-wide architecture and semantics
+    explicit BasicBlockLifter(LiftingContext &lifting);
+    // Loads a lifting context of its own on the first block
     explicit BasicBlockLifter(llvm::LLVMContext &context);
     
-    bool LiftBlock(const std::vector<DecodedInstruction>& instructions,
+    bool LiftBlock(llvm::ArrayRef<DecodedInstruction> instructions,
                    uint64_t block_addr);
+
+    // Lift everything reachable from the address through direct branches,
+    // reading code from the source as the lifter gets to it. Direct callees
+    // are left to the missing block handler.
+    bool LiftTrace(ByteSource& source, uint64_t trace_addr);
     
     llvm::Module* GetModule() { return dest_module.get(); }
     std::unique_ptr<llvm::Module> TakeModule() { return std::move(dest_module); }
     void PushModule(std::unique_ptr<llvm::Module> module);
 
 private:
-    llvm::LLVMContext* context;
+    std::unique_ptr<LiftingContext> owned_lifting;
+    LiftingContext* lifting;
     std::unique_ptr<llvm::Module> dest_module;
-    remill::Arch::ArchPtr arch;
-    std::unique_ptr<remill::IntrinsicTable> intrinsics;
-    
-    bool VerifyIntrinsics();
-}; 
\ No newline at end of file
+
+    bool LiftTraces(ByteSource& source, uint64_t trace_addr, bool lift_callees);
+};
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "ByteSourceTraceManager.h"
+
+#include <glog/logging.h>
+
+namespace {
+
+// Bytes asked for per view, the source may cut a view short at a page end
+constexpr size_t kViewSize = 0x1000;
+
+}  // namespace
+
+ByteSourceTraceManager::ByteSourceTraceManager(ByteSource& source, uint64_t entry, bool lift_callees)
+    : source(source), entry(entry), lift_callees(lift_callees) {}
+
+// Called when we have lifted, i.e. defined the contents, of a new trace
+void ByteSourceTraceManager::SetLiftedTraceDefinition(uint64_t addr, llvm::Function* lifted_func) {
+    traces[addr] = lifted_func;
+    if (addr == entry) {
+        entry_lifted = true;
+    }
+}
+
+// Only traces lifted by this manager are known, the lifter declares the rest
+llvm::Function* ByteSourceTraceManager::GetLiftedTraceDeclaration(uint64_t addr) {
+    auto trace_it = traces.find(addr);
+    return trace_it != traces.end() ? trace_it->second : nullptr;
+}
+
+llvm::Function* ByteSourceTraceManager::GetLiftedTraceDefinition(uint64_t addr) {
+    return GetLiftedTraceDeclaration(addr);
+}
+
+bool ByteSourceTraceManager::TryReadExecutableByte(uint64_t addr, uint8_t* byte) {
+    // Callee traces are lifted after the entry trace is complete
+    if (entry_lifted && !lift_callees) {
+        return false;
+    }
+    // Wraps around for addresses below the view
+    if (addr - view_address >= view.size()) {
+        view = source.Fetch(addr, kViewSize);
+        view_address = addr;
+        if (view.empty()) {
+            VLOG(2) << "No code bytes at 0x" << std::hex << addr;
+            return false;
+        }
+    }
+    *byte = view[addr - view_address];
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Disasm/ByteSource.h"
+
+#include <remill/BC/TraceLifter.h>
+
+#include <llvm/IR/Function.h>
+
+#include <unordered_map>
+
+// Serves remill the code bytes straight from a ByteSource, keeping the last
+// view so consecutive bytes are a bounds check away. With the bytes of a
+// whole function readable the trace lifter follows every direct branch and
+// recovers its control flow graph in one Lift call.
+class ByteSourceTraceManager : public remill::TraceManager {
+public:
+    // Without lift_callees only the entry trace is given bytes, direct
+    // callees are still defined but as a tail call to the missing block
+    // handler, as if their code was not there
+    ByteSourceTraceManager(ByteSource& source, uint64_t entry, bool lift_callees);
+
+    const std::unordered_map<uint64_t, llvm::Function*>& GetTraces() const { return traces; }
+
+protected:
+    void SetLiftedTraceDefinition(uint64_t addr, llvm::Function* lifted_func) override;
+    llvm::Function* GetLiftedTraceDeclaration(uint64_t addr) override;
+    llvm::Function* GetLiftedTraceDefinition(uint64_t addr) override;
+    bool TryReadExecutableByte(uint64_t addr, uint8_t* byte) override;
+
+private:
+    ByteSource& source;
+    uint64_t entry;
+    bool lift_callees;
+    bool entry_lifted = false;
+    uint64_t view_address = 0;
+    llvm::ArrayRef<uint8_t> view;
+    std::unordered_map<uint64_t, llvm::Function*> traces;
+};
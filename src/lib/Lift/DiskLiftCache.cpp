@@ -0,0 +1,298 @@
+#include "DiskLiftCache.h"
+
+#include <glog/logging.h>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+// Set when the remill package reports a version, the semantics hash covers
+// the rest
+#ifndef RECYCLE_REMILL_VERSION
+#define RECYCLE_REMILL_VERSION ""
+#endif
+
+namespace {
+
+// Bumped when the layout of the key or the lifted modules changes
+constexpr uint32_t kCacheFormat = 1;
+constexpr const char* kExtension = ".bc";
+// Temporary files older than this were left behind by a session that died
+// while writing, younger ones may belong to a session still running
+constexpr auto kStaleTempAge = std::chrono::hours(1);
+
+template <typename T>
+void AppendValue(std::vector<uint8_t>& buffer, const T& value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+void AppendString(std::vector<uint8_t>& buffer, const std::string& value) {
+    AppendValue(buffer, static_cast<uint32_t>(value.size()));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+std::string ToHex(llvm::ArrayRef<uint8_t> digest) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (const auto byte : digest) {
+        hex.push_back(kHex[byte >> 4]);
+        hex.push_back(kHex[byte & 0xf]);
+    }
+    return hex;
+}
+
+}  // namespace
+
+DiskLiftCache::DiskLiftCache(std::string directory, uint64_t max_bytes)
+    : directory(std::move(directory)), max_bytes(max_bytes) {}
+
+bool DiskLiftCache::Open() {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        LOG(ERROR) << "Could not create lift cache directory " << directory << ": " << ec.message();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::filesystem::directory_iterator it(directory, ec);
+    if (ec) {
+        LOG(ERROR) << "Could not read lift cache directory " << directory << ": " << ec.message();
+        return false;
+    }
+    const auto now = std::filesystem::file_time_type::clock::now();
+    for (; it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        // Files may be written, renamed or evicted by other sessions meanwhile,
+        // one that can't be inspected is skipped
+        std::error_code file_ec;
+        const auto& path = it->path();
+        const auto last_write = it->last_write_time(file_ec);
+        if (file_ec) {
+            continue;
+        }
+        if (path.extension() == ".tmp") {
+            if (now - last_write > kStaleTempAge) {
+                std::filesystem::remove(path, file_ec);
+            }
+            continue;
+        }
+        if (path.extension() != kExtension || !it->is_regular_file(file_ec)) {
+            continue;
+        }
+        Entry entry;
+        entry.size = it->file_size(file_ec);
+        if (file_ec) {
+            continue;
+        }
+        entry.last_use = last_write;
+        entries[path.stem().string()] = entry;
+        total_bytes += entry.size;
+    }
+    if (ec) {
+        LOG(WARNING) << "Stopped reading lift cache directory " << directory << ": " << ec.message();
+    }
+    LOG(INFO) << "Lift cache " << directory << ": " << std::dec << entries.size() << " blocks, "
+              << total_bytes / 1024 << " KiB";
+    Evict();
+    return true;
+}
+
+std::string DiskLiftCache::GetKey(const std::string& arch, const std::string& semantics_hash, uint64_t address,
+                                  llvm::ArrayRef<DecodedInstruction> instructions) {
+    std::vector<uint8_t> material;
+    AppendValue(material, kCacheFormat);
+    AppendString(material, arch);
+    AppendString(material, semantics_hash);
+    AppendString(material, RECYCLE_REMILL_VERSION);
+    AppendString(material, LLVM_VERSION_STRING);
+    AppendValue(material, address);
+    // Addresses too, the instructions of a superblock are not contiguous
+    for (const auto& inst : instructions) {
+        AppendValue(material, inst.address);
+        AppendValue(material, inst.length);
+        material.insert(material.end(), inst.bytes.begin(), inst.bytes.begin() + inst.length);
+    }
+
+    return ToHex(llvm::SHA1::hash(material));
+}
+
+std::string DiskLiftCache::HashModule(const llvm::Module& module) {
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(module, stream);
+    return ToHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(llvm::StringRef(bitcode.data(), bitcode.size()))));
+}
+
+std::filesystem::path DiskLiftCache::GetPath(const std::string& key) const {
+    return directory / (key + kExtension);
+}
+
+std::unique_ptr<llvm::Module> DiskLiftCache::Load(const std::string& key, llvm::LLVMContext& context) {
+    const auto path = GetPath(key);
+    bool indexed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        indexed = entries.count(key) != 0;
+    }
+    if (!indexed) {
+        // Other sessions may have stored the block since the directory was indexed
+        std::error_code ec;
+        const uint64_t size = std::filesystem::file_size(path, ec);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ec) {
+            misses++;
+            return nullptr;
+        }
+        if (entries.emplace(key, Entry{size, std::filesystem::file_time_type::clock::now()}).second) {
+            total_bytes += size;
+        }
+    }
+
+    auto buffer = llvm::MemoryBuffer::getFile(path.string());
+    if (!buffer) {
+        LOG(WARNING) << "Lift cache entry " << path << " is gone: " << buffer.getError().message();
+        std::lock_guard<std::mutex> lock(mutex);
+        total_bytes -= std::min(total_bytes, entries[key].size);
+        entries.erase(key);
+        misses++;
+        return nullptr;
+    }
+    auto module = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), context);
+    if (!module) {
+        LOG(WARNING) << "Lift cache entry " << path << " is corrupt: " << llvm::toString(module.takeError());
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        std::lock_guard<std::mutex> lock(mutex);
+        total_bytes -= std::min(total_bytes, entries[key].size);
+        entries.erase(key);
+        misses++;
+        return nullptr;
+    }
+
+    // The modification time records the use for eviction in later sessions
+    const auto now = std::filesystem::file_time_type::clock::now();
+    std::error_code ec;
+    std::filesystem::last_write_time(path, now, ec);
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[key].last_use = now;
+    hits++;
+    return std::move(*module);
+}
+
+bool DiskLiftCache::Store(const std::string& key, const llvm::Module& module) {
+    const auto path = GetPath(key);
+    std::filesystem::path temp_path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Sessions in other processes may store the same key at the same time
+        temp_path = directory / (key + "." + std::to_string(llvm::sys::Process::getProcessId()) + "." +
+                                 std::to_string(temp_files++) + ".tmp");
+    }
+
+    // Written under a temporary name and renamed, so readers never see half a file
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream file(temp_path.string(), ec);
+        if (ec) {
+            LOG(WARNING) << "Could not write lift cache entry " << temp_path << ": " << ec.message();
+            return false;
+        }
+        llvm::WriteBitcodeToFile(module, file);
+        file.close();
+        if (file.has_error()) {
+            LOG(WARNING) << "Could not write lift cache entry " << temp_path << ": " << file.error().message();
+            file.clear_error();
+            std::filesystem::remove(temp_path, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(temp_path, ec);
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        LOG(WARNING) << "Could not store lift cache entry " << path << ": " << ec.message();
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = entries[key];
+    total_bytes = total_bytes - std::min(total_bytes, entry.size) + size;
+    entry.size = size;
+    entry.last_use = std::filesystem::file_time_type::clock::now();
+    stores++;
+    Evict();
+    return true;
+}
+
+// Called with the mutex held
+void DiskLiftCache::Evict() {
+    if (total_bytes <= max_bytes) {
+        return;
+    }
+    std::vector<std::pair<std::filesystem::file_time_type, std::string>> by_age;
+    by_age.reserve(entries.size());
+    for (const auto& [key, entry] : entries) {
+        by_age.emplace_back(entry.last_use, key);
+    }
+    std::sort(by_age.begin(), by_age.end());
+
+    for (const auto& [last_use, key] : by_age) {
+        if (total_bytes <= max_bytes) {
+            break;
+        }
+        std::error_code ec;
+        std::filesystem::remove(GetPath(key), ec);
+        total_bytes -= std::min(total_bytes, entries[key].size);
+        entries.erase(key);
+        evictions++;
+    }
+    VLOG(1) << "Lift cache evicted down to " << std::dec << total_bytes / 1024 << " KiB";
+}
+
+size_t DiskLiftCache::GetHits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+size_t DiskLiftCache::GetMisses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+size_t DiskLiftCache::GetStores() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stores;
+}
+
+size_t DiskLiftCache::GetEvictions() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return evictions;
+}
+
+size_t DiskLiftCache::GetEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+uint64_t DiskLiftCache::GetSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_bytes;
+}
+
+double DiskLiftCache::GetHitRate() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t lookups = hits + misses;
+    return lookups ? static_cast<double>(hits) / lookups : 0.0;
+}
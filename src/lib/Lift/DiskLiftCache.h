@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Disasm/DecodedInstruction.h"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Lifted blocks kept on disk across sessions, one bitcode file per block
+// named after a hash of the architecture, the semantics module, block
+// address, instruction bytes and the remill and LLVM versions. The same code
+// at the same address in another dump is parsed back instead of lifted again.
+// The directory is held under a size limit by dropping the least recently
+// used files, use is tracked through their modification time. Thread-safe.
+class DiskLiftCache {
+public:
+    DiskLiftCache(std::string directory, uint64_t max_bytes);
+
+    // Create the directory and index the files already in it
+    bool Open();
+
+    static std::string GetKey(const std::string& arch, const std::string& semantics_hash, uint64_t address,
+                              llvm::ArrayRef<DecodedInstruction> instructions);
+
+    // Hash of the module's bitcode, identifies the semantics blocks were lifted with
+    static std::string HashModule(const llvm::Module& module);
+
+    // The cached module parsed into the context, null on a miss
+    std::unique_ptr<llvm::Module> Load(const std::string& key, llvm::LLVMContext& context);
+
+    // Write the module under the key, then evict down to the size limit
+    bool Store(const std::string& key, const llvm::Module& module);
+
+    size_t GetHits() const;
+    size_t GetMisses() const;
+    size_t GetStores() const;
+    size_t GetEvictions() const;
+    size_t GetEntryCount() const;
+    uint64_t GetSize() const;
+    double GetHitRate() const;
+
+private:
+    struct Entry {
+        uint64_t size = 0;
+        std::filesystem::file_time_type last_use;
+    };
+
+    std::filesystem::path directory;
+    uint64_t max_bytes;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t total_bytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t stores = 0;
+    size_t evictions = 0;
+    size_t temp_files = 0;
+
+    std::filesystem::path GetPath(const std::string& key) const;
+    void Evict();
+};
@@ -0,0 +1,81 @@
+#include "LiftWorkerPool.h"
+
+#include "Lift/BasicBlockLifter.h"
+
+#include <glog/logging.h>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace {
+    // remill and XED set up process wide tables on first use, so the workers
+    // load their semantics one at a time
+    std::mutex initialize_mutex;
+}
+
+LiftWorkerPool::LiftWorkerPool(size_t thread_count) : pool(thread_count) {
+    // One worker per thread, so a running task always finds an idle one
+    workers.resize(pool.GetThreadCount());
+    for (auto& worker : workers) {
+        worker.context = std::make_unique<llvm::LLVMContext>();
+        worker.lifting = std::make_unique<LiftingContext>(*worker.context);
+        idle.push_back(&worker);
+    }
+}
+
+std::vector<LiftWorkerPool::Result> LiftWorkerPool::Lift(const std::vector<Request>& requests) {
+    std::vector<Result> results(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        pool.Submit([this, &request = requests[i], &result = results[i]] { LiftOne(request, result); });
+    }
+    pool.Wait();
+    return results;
+}
+
+void LiftWorkerPool::LiftOne(const Request& request, Result& result) {
+    Worker* worker = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        worker = idle.back();
+        idle.pop_back();
+    }
+
+    result.address = request.address;
+    bool initialized = false;
+    {
+        std::lock_guard<std::mutex> lock(initialize_mutex);
+        initialized = worker->lifting->Initialize();
+    }
+    BasicBlockLifter lifter(*worker->lifting);
+    if (!initialized) {
+        LOG(ERROR) << "Worker failed to load the semantics for block at IP: 0x" << std::hex << request.address;
+    } else if (lifter.LiftBlock(request.instructions, request.address)) {
+        // The module belongs to the worker's context, only its bitcode leaves the thread
+        const auto module = lifter.TakeModule();
+        llvm::raw_svector_ostream stream(result.bitcode);
+        llvm::WriteBitcodeToFile(*module, stream);
+        result.lifted = true;
+    } else {
+        LOG(ERROR) << "Worker failed to lift block at IP: 0x" << std::hex << request.address;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.push_back(worker);
+}
+
+std::unique_ptr<llvm::Module> LiftWorkerPool::ParseResult(const Result& result, llvm::LLVMContext& context) {
+    if (!result.lifted) {
+        return nullptr;
+    }
+    const auto buffer = llvm::MemoryBuffer::getMemBuffer(
+        llvm::StringRef(result.bitcode.data(), result.bitcode.size()), "lifted", false);
+    auto module = llvm::parseBitcodeFile(buffer->getMemBufferRef(), context);
+    if (!module) {
+        LOG(ERROR) << "Failed to parse lifted block at IP: 0x" << std::hex << result.address << ": "
+                   << llvm::toString(module.takeError());
+        return nullptr;
+    }
+    return std::move(*module);
+}
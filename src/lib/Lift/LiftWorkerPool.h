@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Disasm/DecodedInstruction.h"
+#include "Discovery/ThreadPool.h"
+#include "Lift/LiftingContext.h"
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Lifts independent blocks on worker threads. LLVM state can't be shared
+// between threads, so every worker owns an LLVMContext and a lifting context
+// of its own, the semantics are loaded into it on the worker's first block,
+// one worker at a time.
+// Lifted blocks come back as bitcode for the caller to parse into the session
+// context.
+class LiftWorkerPool {
+public:
+    struct Request {
+        uint64_t address = 0;
+        std::vector<DecodedInstruction> instructions;
+    };
+
+    struct Result {
+        uint64_t address = 0;
+        bool lifted = false;
+        llvm::SmallVector<char, 0> bitcode;
+    };
+
+    // 0 uses one worker per hardware thread
+    explicit LiftWorkerPool(size_t thread_count = 0);
+
+    LiftWorkerPool(const LiftWorkerPool&) = delete;
+    LiftWorkerPool& operator=(const LiftWorkerPool&) = delete;
+
+    // Lift every request and wait for all of them, results are in request order
+    std::vector<Result> Lift(const std::vector<Request>& requests);
+
+    // The lifted block parsed into the context, null if it was not lifted
+    static std::unique_ptr<llvm::Module> ParseResult(const Result& result, llvm::LLVMContext& context);
+
+    size_t GetThreadCount() const { return pool.GetThreadCount(); }
+
+private:
+    struct Worker {
+        std::unique_ptr<llvm::LLVMContext> context;
+        std::unique_ptr<LiftingContext> lifting;
+    };
+
+    std::vector<Worker> workers;
+    std::vector<Worker*> idle;
+    std::mutex mutex;
+    // Declared last so the threads are joined before the workers go away
+    Discovery::ThreadPool pool;
+
+    void LiftOne(const Request& request, Result& result);
+};
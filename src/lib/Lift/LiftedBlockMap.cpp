@@ -0,0 +1,74 @@
+#include "LiftedBlockMap.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+void LiftedBlockMap::Add(uint64_t address, llvm::ArrayRef<DecodedInstruction> instructions) {
+    auto& block = blocks[address];
+    block.address = address;
+    block.instructions.assign(instructions.begin(), instructions.end());
+}
+
+const LiftedBlockMap::Block* LiftedBlockMap::FindContaining(uint64_t address) const {
+    auto it = blocks.upper_bound(address);
+    if (it == blocks.begin()) {
+        return nullptr;
+    }
+    --it;
+    return address < it->second.GetEnd() ? &it->second : nullptr;
+}
+
+bool LiftedBlockMap::Split(uint64_t address, Block& head, Block& tail) {
+    // Only a block starting strictly before the address can be split
+    auto it = blocks.lower_bound(address);
+    if (it == blocks.begin()) {
+        return false;
+    }
+    --it;
+    auto& block = it->second;
+    if (address >= block.GetEnd()) {
+        return false;
+    }
+
+    const auto split_at = std::find_if(block.instructions.begin(), block.instructions.end(),
+                                       [address](const DecodedInstruction& inst) { return inst.address == address; });
+    if (split_at == block.instructions.end()) {
+        VLOG(1) << "0x" << std::hex << address << " is inside an instruction of block 0x" << block.address;
+        return false;
+    }
+
+    VLOG(1) << "Splitting block 0x" << std::hex << block.address << " at 0x" << address;
+    auto existing = blocks.find(address);
+    if (existing == blocks.end()) {
+        auto& new_tail = blocks[address];
+        new_tail.address = address;
+        new_tail.instructions.assign(split_at, block.instructions.end());
+        tail = new_tail;
+    } else {
+        tail = existing->second;
+    }
+    block.instructions.erase(split_at, block.instructions.end());
+    head = block;
+    splits++;
+    return true;
+}
+
+const LiftedBlockMap::Block* LiftedBlockMap::GetBlock(uint64_t address) const {
+    const auto it = blocks.find(address);
+    return it != blocks.end() ? &it->second : nullptr;
+}
+
+uint64_t LiftedBlockMap::NextStartAfter(uint64_t address) const {
+    const auto it = blocks.upper_bound(address);
+    return it != blocks.end() ? it->first : UINT64_MAX;
+}
+
+std::vector<const LiftedBlockMap::Block*> LiftedBlockMap::GetBlocks() const {
+    std::vector<const Block*> result;
+    result.reserve(blocks.size());
+    for (const auto& [address, block] : blocks) {
+        result.push_back(&block);
+    }
+    return result;
+}
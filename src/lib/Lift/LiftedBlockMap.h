@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Disasm/DecodedInstruction.h"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Lifted blocks by the address range they cover. A target that lands inside
+// a block on one of its instruction boundaries splits the block: the head is
+// cut short to fall through to the target and the decoded tail becomes the
+// target's block, so no byte range is lifted twice.
+class LiftedBlockMap {
+public:
+    struct Block {
+        uint64_t address = 0;
+        std::vector<DecodedInstruction> instructions;
+
+        uint64_t GetEnd() const { return instructions.empty() ? address : instructions.back().GetNextAddress(); }
+    };
+
+    // Replaces a block already recorded at the same address
+    void Add(uint64_t address, llvm::ArrayRef<DecodedInstruction> instructions);
+
+    bool Contains(uint64_t address) const { return blocks.count(address) != 0; }
+
+    // Block whose range covers the address, null if none.
+    // Blocks that overlap at different instruction boundaries are not merged,
+    // the closest one starting at or before the address is checked.
+    const Block* FindContaining(uint64_t address) const;
+
+    // Split the containing block at the address. False if no block contains
+    // it or the address falls inside one of its instructions. If a block
+    // already starts at the address only the head is cut, `tail` is that block.
+    bool Split(uint64_t address, Block& head, Block& tail);
+
+    const Block* GetBlock(uint64_t address) const;
+
+    // Start of the first block after the address, UINT64_MAX if there is none
+    uint64_t NextStartAfter(uint64_t address) const;
+    size_t GetBlockCount() const { return blocks.size(); }
+    size_t GetSplitCount() const { return splits; }
+
+    // Blocks in ascending address order
+    std::vector<const Block*> GetBlocks() const;
+
+private:
+    std::map<uint64_t, Block> blocks;
+    size_t splits = 0;
+};
@@ -0,0 +1,113 @@
+#include "LiftingContext.h"
+
+#include "BitcodeManipulation/ExtractFunctions.h"
+
+#include <remill/BC/Util.h>
+#include <glog/logging.h>
+
+#include <llvm/IR/Constants.h>
+
+#include <vector>
+
+LiftingContext::LiftingContext(llvm::LLVMContext& context) : context(&context) {}
+
+bool LiftingContext::Initialize() {
+    if (semantics) {
+        return true;
+    }
+    if (failed) {
+        return false;
+    }
+    failed = true;
+
+    VLOG(1) << "Creating architecture for " << GetArchName();
+    arch = remill::Arch::Get(*context, kOS, kArch);
+    if (!arch) {
+        LOG(ERROR) << "Failed to create architecture";
+        return false;
+    }
+
+    LOG(INFO) << "Loading architecture semantics";
+    auto module = remill::LoadArchSemantics(arch.get());
+    if (!module) {
+        LOG(ERROR) << "Failed to load architecture semantics";
+        return false;
+    }
+
+    VLOG(1) << "Initializing intrinsics table";
+    intrinsics = std::make_unique<remill::IntrinsicTable>(module.get());
+    if (!VerifyIntrinsics()) {
+        LOG(ERROR) << "Failed to verify critical intrinsics";
+        return false;
+    }
+
+    for (const auto& global : module->global_values()) {
+        loaded.insert(&global);
+    }
+    LOG(INFO) << "Loaded " << std::dec << module->size() << " semantics functions";
+    semantics = std::move(module);
+    failed = false;
+    return true;
+}
+
+const std::string& LiftingContext::GetSemanticsHash() {
+    if (semantics_hash.empty() && Initialize()) {
+        semantics_hash = DiskLiftCache::HashModule(*semantics);
+        VLOG(1) << "Semantics hash: " << semantics_hash;
+    }
+    return semantics_hash;
+}
+
+bool LiftingContext::VerifyIntrinsics() const {
+    if (!intrinsics->error) {
+        LOG(ERROR) << "Missing critical intrinsic: __remill_error";
+        return false;
+    }
+    if (!intrinsics->jump) {
+        LOG(ERROR) << "Missing critical intrinsic: __remill_jump";
+        return false;
+    }
+    if (!intrinsics->function_call) {
+        LOG(ERROR) << "Missing critical intrinsic: __remill_function_call";
+        return false;
+    }
+    if (!intrinsics->function_return) {
+        LOG(ERROR) << "Missing critical intrinsic: __remill_function_return";
+        return false;
+    }
+    if (!intrinsics->missing_block) {
+        LOG(ERROR) << "Missing critical intrinsic: __remill_missing_block";
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<llvm::Module> LiftingContext::ExtractLifted(llvm::ArrayRef<llvm::Function*> functions) {
+    auto extracted = BitcodeManipulation::ExtractFunctions(*semantics, functions);
+    DiscardLifted();
+    return extracted;
+}
+
+void LiftingContext::DiscardLifted() {
+    if (!semantics) {
+        return;
+    }
+    std::vector<llvm::GlobalValue*> added;
+    for (auto& global : semantics->global_values()) {
+        if (!loaded.count(&global)) {
+            added.push_back(&global);
+        }
+    }
+    // Lifted functions call each other, unlink them all before erasing any
+    for (auto* global : added) {
+        if (auto* function = llvm::dyn_cast<llvm::Function>(global)) {
+            function->dropAllReferences();
+        }
+    }
+    for (auto* global : added) {
+        if (!global->use_empty()) {
+            global->replaceAllUsesWith(llvm::UndefValue::get(global->getType()));
+        }
+        global->eraseFromParent();
+    }
+}
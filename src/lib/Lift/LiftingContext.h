@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Lift/DiskLiftCache.h"
+
+#include <remill/Arch/Arch.h>
+#include <remill/BC/IntrinsicTable.h>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+// Lifting state shared by all blocks of a session: the remill architecture,
+// the x86 semantics module and its intrinsics table are loaded once. Blocks
+// are lifted into the semantics module, extracted into a module of their own
+// with just the semantics they use, then removed again so the semantics stay
+// as loaded. Like the LLVMContext it lives in, it is used by one thread at a
+// time.
+class LiftingContext {
+public:
+    static constexpr const char* kOS = "windows";
+    static constexpr const char* kArch = "amd64";
+
+    explicit LiftingContext(llvm::LLVMContext& context);
+
+    // Load the architecture and semantics, done on first use. False if they
+    // could not be loaded, later calls then fail as well.
+    bool Initialize();
+
+    llvm::LLVMContext& GetContext() const { return *context; }
+    const remill::Arch* GetArch() const { return arch.get(); }
+    const remill::IntrinsicTable* GetIntrinsics() const { return intrinsics.get(); }
+    std::string GetArchName() const { return std::string(kOS) + "/" + kArch; }
+
+    // Hash of the semantics as loaded, part of the lift cache keys. Loads them
+    // on first use, empty if they could not be loaded
+    const std::string& GetSemanticsHash();
+
+    // Lifted blocks from earlier sessions, optional and not owned
+    void SetDiskCache(DiskLiftCache* cache) { disk_cache = cache; }
+    DiskLiftCache* GetDiskCache() const { return disk_cache; }
+
+    // Copy lifted functions and the semantics they reach into a new module,
+    // then drop everything added to the semantics module since it was loaded
+    std::unique_ptr<llvm::Module> ExtractLifted(llvm::ArrayRef<llvm::Function*> functions);
+
+    // Drop everything added to the semantics module, e.g. after a failed lift
+    void DiscardLifted();
+
+private:
+    llvm::LLVMContext* context;
+    remill::Arch::ArchPtr arch;
+    std::unique_ptr<llvm::Module> semantics;
+    std::unique_ptr<remill::IntrinsicTable> intrinsics;
+    // Globals of the semantics module as loaded
+    std::unordered_set<const llvm::GlobalValue*> loaded;
+    bool failed = false;
+    std::string semantics_hash;
+    DiskLiftCache* disk_cache = nullptr;
+
+    bool VerifyIntrinsics() const;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MinidumpContext {
+
+// Windows PAGE_* protection flags, as stored in the dump
+constexpr uint32_t kPageNoAccess = 0x01;
+constexpr uint32_t kPageReadOnly = 0x02;
+constexpr uint32_t kPageReadWrite = 0x04;
+constexpr uint32_t kPageWriteCopy = 0x08;
+constexpr uint32_t kPageExecute = 0x10;
+constexpr uint32_t kPageExecuteRead = 0x20;
+constexpr uint32_t kPageExecuteReadWrite = 0x40;
+constexpr uint32_t kPageExecuteWriteCopy = 0x80;
+
+// MEM_IMAGE region type, memory mapped from an executable image
+constexpr uint32_t kMemImage = 0x1000000;
+
+// IMAGE_SCN_* section characteristics
+constexpr uint32_t kSectionCode = 0x00000020;
+constexpr uint32_t kSectionInitializedData = 0x00000040;
+constexpr uint32_t kSectionMemExecute = 0x20000000;
+constexpr uint32_t kSectionMemRead = 0x40000000;
+constexpr uint32_t kSectionMemWrite = 0x80000000;
+
+// Section of a loaded PE image, from the in-memory section table
+struct SectionInfo {
+    std::string name;
+    uint64_t address;
+    uint64_t size;
+    uint32_t characteristics;
+
+    bool IsExecutable() const { return (characteristics & kSectionMemExecute) != 0; }
+    bool IsWritable() const { return (characteristics & kSectionMemWrite) != 0; }
+};
+
+// Module loaded into the captured address space
+struct ModuleInfo {
+    uint64_t base;
+    uint64_t size;
+    std::string name;
+    std::vector<SectionInfo> sections;  // Sorted by address, empty without PE headers
+    uint64_t iat_address = 0;           // Import address table, 0 if there is none
+    uint64_t iat_size = 0;
+};
+
+// Register state of a captured thread needed to start lifting from it
+struct ThreadContext {
+    uint32_t id;
+    uint64_t instruction_pointer;
+    uint64_t stack_pointer;
+    uint64_t teb;
+};
+
+// What the memory source knows about an address
+struct MemoryInfo {
+    bool mapped = false;
+    uint32_t protect = 0;               // 0 when the source has no protection info
+    uint32_t type = 0;
+    uint64_t region_base = 0;           // Range of the containing region
+    uint64_t region_size = 0;
+    const ModuleInfo* module = nullptr; // Owned by the memory source
+    const SectionInfo* section = nullptr;
+
+    bool IsExecutable() const {
+        return (protect & (kPageExecute | kPageExecuteRead | kPageExecuteReadWrite | kPageExecuteWriteCopy)) != 0;
+    }
+
+    bool IsWritable() const {
+        return (protect & (kPageReadWrite | kPageWriteCopy | kPageExecuteReadWrite | kPageExecuteWriteCopy)) != 0;
+    }
+
+    bool IsImage() const {
+        return type == kMemImage || module != nullptr;
+    }
+
+    // Whole range lies in the containing region
+    bool ContainsRange(uint64_t address, uint64_t size) const {
+        return mapped && address >= region_base && address - region_base + size <= region_size;
+    }
+
+    // Known to be mapped without execute permission
+    bool IsNonExecutable() const {
+        return mapped && protect != 0 && !IsExecutable();
+    }
+
+    // Read-only image memory, its contents can't change during execution.
+    // Section boundaries from the PE headers win over the region type
+    bool IsImmutable() const {
+        if (!mapped || IsWritable()) {
+            return false;
+        }
+        if (section) {
+            return !section->IsWritable();
+        }
+        return protect != 0 && IsImage();
+    }
+};
+
+// Outcome of a checked read
+enum class ReadStatus {
+    Ok,
+    Partial,    // Starts in mapped memory but runs past it
+    Unmapped,   // Address is not in the memory source
+};
+
+struct ReadResult {
+    ReadStatus status = ReadStatus::Unmapped;
+    std::vector<uint8_t> data;
+
+    bool IsUnmapped() const { return status == ReadStatus::Unmapped; }
+};
+
+// Module containing the address in a list sorted by base, or nullptr
+inline const ModuleInfo* FindModule(const std::vector<ModuleInfo>& modules, uint64_t address) {
+    auto it = std::upper_bound(modules.begin(), modules.end(), address,
+                               [](uint64_t addr, const ModuleInfo& module) { return addr < module.base; });
+    if (it == modules.begin()) {
+        return nullptr;
+    }
+    --it;
+    return address - it->base < it->size ? &*it : nullptr;
+}
+
+// Section of the module containing the address, or nullptr
+inline const SectionInfo* FindSection(const ModuleInfo& module, uint64_t address) {
+    auto it = std::upper_bound(module.sections.begin(), module.sections.end(), address,
+                               [](uint64_t addr, const SectionInfo& section) { return addr < section.address; });
+    if (it == module.sections.begin()) {
+        return nullptr;
+    }
+    --it;
+    return address - it->address < it->size ? &*it : nullptr;
+}
+
+}  // namespace MinidumpContext
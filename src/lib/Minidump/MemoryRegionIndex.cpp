@@ -0,0 +1,129 @@
+#include "MemoryRegionIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace MinidumpContext {
+
+void MemoryRegionIndex::Build(std::vector<MemoryRegion> new_regions) {
+    new_regions.erase(
+        std::remove_if(new_regions.begin(), new_regions.end(),
+                       [](const MemoryRegion& region) { return region.size == 0 || !region.data; }),
+        new_regions.end());
+
+    std::sort(new_regions.begin(), new_regions.end(),
+              [](const MemoryRegion& a, const MemoryRegion& b) { return a.base < b.base; });
+
+    regions = std::move(new_regions);
+    starts.clear();
+    starts.reserve(regions.size());
+    for (const auto& region : regions) {
+        starts.push_back(region.base);
+    }
+}
+
+const MemoryRegion* MemoryRegionIndex::Find(uint64_t address) const {
+    // First region starting after the address, the candidate is the one before it
+    auto it = std::upper_bound(starts.begin(), starts.end(), address);
+    if (it == starts.begin()) {
+        return nullptr;
+    }
+    const auto& region = regions[std::distance(starts.begin(), it) - 1];
+    if (address - region.base >= region.size) {
+        return nullptr;
+    }
+    return &region;
+}
+
+uint64_t MemoryRegionIndex::NextRegionBase(uint64_t address) const {
+    auto it = std::upper_bound(starts.begin(), starts.end(), address);
+    return it == starts.end() ? UINT64_MAX : *it;
+}
+
+llvm::ArrayRef<uint8_t> MemoryRegionIndex::View(uint64_t address, size_t size) const {
+    const auto* region = Find(address);
+    if (!region) {
+        return {};
+    }
+    const uint64_t offset = address - region->base;
+    const size_t available = std::min<uint64_t>(region->size - offset, size);
+    return llvm::ArrayRef<uint8_t>(region->data + offset, available);
+}
+
+size_t MemoryRegionIndex::Read(uint64_t address, uint8_t* out, size_t size) const {
+    const auto* region = Find(address);
+    if (!region) {
+        return 0;
+    }
+
+    size_t copied = 0;
+    const auto* end = regions.data() + regions.size();
+    while (copied < size) {
+        const uint64_t offset = address - region->base;
+        const size_t chunk = std::min<uint64_t>(region->size - offset, size - copied);
+        std::memcpy(out + copied, region->data + offset, chunk);
+        copied += chunk;
+        address += chunk;
+
+        // Continue only if the next region starts exactly where this one ends
+        ++region;
+        if (copied == size || region == end || region->base != address) {
+            break;
+        }
+    }
+    return copied;
+}
+
+size_t MemoryRegionIndex::Locate(uint64_t address, size_t hint) const {
+    // Ranges are usually sorted, so try the region right after the hint first
+    if (hint + 1 < regions.size() && address - regions[hint + 1].base < regions[hint + 1].size) {
+        return hint + 1;
+    }
+
+    auto search_begin = starts.begin();
+    if (hint < starts.size() && starts[hint] <= address) {
+        search_begin += hint;
+    }
+    auto it = std::upper_bound(search_begin, starts.end(), address);
+    if (it == starts.begin()) {
+        return regions.size();
+    }
+    const size_t idx = std::distance(starts.begin(), it) - 1;
+    if (address - regions[idx].base >= regions[idx].size) {
+        return regions.size();
+    }
+    return idx;
+}
+
+size_t MemoryRegionIndex::ReadRanges(llvm::MutableArrayRef<MemoryRange> ranges) const {
+    size_t complete = 0;
+    size_t current = regions.size();
+
+    for (auto& range : ranges) {
+        range.bytes_read = 0;
+        while (range.bytes_read < range.size) {
+            const uint64_t address = range.address + range.bytes_read;
+            if (current == regions.size() ||
+                address < regions[current].base ||
+                address - regions[current].base >= regions[current].size) {
+                current = Locate(address, current);
+                if (current == regions.size()) {
+                    break;
+                }
+            }
+
+            const auto& region = regions[current];
+            const uint64_t offset = address - region.base;
+            const size_t chunk = std::min<uint64_t>(region.size - offset, range.size - range.bytes_read);
+            std::memcpy(range.buffer + range.bytes_read, region.data + offset, chunk);
+            range.bytes_read += chunk;
+        }
+        if (range.bytes_read == range.size) {
+            complete++;
+        }
+    }
+    return complete;
+}
+
+}  // namespace MinidumpContext
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+
+namespace MinidumpContext {
+
+// Single memory range captured in the dump
+struct MemoryRegion {
+    uint64_t base;
+    uint64_t size;          // Number of bytes backed by data
+    const uint8_t* data;    // Points into the mapped dump file
+    uint32_t protect;       // PAGE_* protection flags
+    uint32_t type;          // MEM_* region type
+};
+
+// Destination of a batched read
+struct MemoryRange {
+    uint64_t address;
+    size_t size;
+    uint8_t* buffer;        // Caller-owned, at least `size` bytes
+    size_t bytes_read;      // Filled by ReadRanges
+};
+
+// Flat, sorted table of dump memory ranges. Region starts are kept in their
+// own array so the binary search only touches a dense run of uint64_t values.
+class MemoryRegionIndex {
+public:
+    // Sort the regions and build the lookup table, empty regions are dropped
+    void Build(std::vector<MemoryRegion> regions);
+
+    // Region containing the address or nullptr
+    const MemoryRegion* Find(uint64_t address) const;
+
+    // Base of the first region above the address, UINT64_MAX if there is none
+    uint64_t NextRegionBase(uint64_t address) const;
+
+    // Non-owning view, truncated at the end of the containing region
+    llvm::ArrayRef<uint8_t> View(uint64_t address, size_t size) const;
+
+    // Copy memory into `out`, continuing into adjacent regions when the
+    // range spans them. Returns the number of bytes copied.
+    size_t Read(uint64_t address, uint8_t* out, size_t size) const;
+
+    // Fill a batch of ranges sorted by address in a single forward pass.
+    // Back-to-back ranges are served from the region found for the previous
+    // one, a lookup only happens when a range leaves it. Returns the number
+    // of ranges that were read completely.
+    size_t ReadRanges(llvm::MutableArrayRef<MemoryRange> ranges) const;
+
+    const std::vector<MemoryRegion>& GetRegions() const { return regions; }
+    size_t GetRegionCount() const { return regions.size(); }
+
+private:
+    std::vector<uint64_t> starts;
+    std::vector<MemoryRegion> regions;
+
+    // Index of the region containing the address, starting from a hint.
+    // Returns the region count if the address is not mapped.
+    size_t Locate(uint64_t address, size_t hint) const;
+};
+
+}  // namespace MinidumpContext
@@ -1,7 +1,10 @@
 #include "MinidumpContext.h"
+#include "PEImage.h"
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace MinidumpContext {
 
 MinidumpContext::MinidumpContext(const std::string& dump_path_)
@@ -28,10 +31,59 @@ bool MinidumpContext::Initialize() {
         return false;
     }
 
+    BuildRegionIndex();
+    BuildModuleList();
+
     VLOG(1) << "Successfully initialized minidump parser";
     return true;
 }
 
+void MinidumpContext::BuildRegionIndex() {
+    std::vector<MemoryRegion> regions;
+    const auto& blocks = parser->GetMem();
+    regions.reserve(blocks.size());
+    for (const auto& [base, block] : blocks) {
+        regions.push_back({block.BaseAddress, block.DataSize, block.Data, block.Protect, block.Type});
+    }
+    region_index.Build(std::move(regions));
+    VLOG(1) << "Indexed " << region_index.GetRegionCount() << " memory regions";
+}
+
+void MinidumpContext::BuildModuleList() {
+    modules.clear();
+    for (const auto& [base, module] : parser->GetModules()) {
+        modules.push_back({module.BaseOfImage, module.SizeOfImage, module.ModuleName});
+        VLOG(1) << "Module " << module.ModuleName << " at 0x" << std::hex << module.BaseOfImage
+                << " size: 0x" << module.SizeOfImage;
+    }
+    std::sort(modules.begin(), modules.end(),
+              [](const ModuleInfo& a, const ModuleInfo& b) { return a.base < b.base; });
+
+    // Section tables come from the headers mapped at each module base
+    const auto read = [this](uint64_t address, uint8_t* out, size_t size) {
+        return region_index.Read(address, out, size);
+    };
+    for (auto& module : modules) {
+        ParsePEImage(module, read);
+    }
+}
+
+MemoryInfo MinidumpContext::QueryMemory(uint64_t address) const {
+    MemoryInfo info;
+    if (const auto* region = region_index.Find(address)) {
+        info.mapped = true;
+        info.protect = region->protect;
+        info.type = region->type;
+        info.region_base = region->base;
+        info.region_size = region->size;
+    }
+    info.module = FindModule(modules, address);
+    if (info.module) {
+        info.section = FindSection(*info.module, address);
+    }
+    return info;
+}
+
 uint64_t MinidumpContext::GetInstructionPointer() const {
     auto foreground_thread_id = parser->GetForegroundThreadId();
     const auto& threads = parser->GetThreads();
@@ -51,14 +103,84 @@ uint64_t MinidumpContext::GetInstructionPointer() const {
 
 
 std::vector<uint8_t> MinidumpContext::ReadMemory(uint64_t address, size_t size) const {
-    auto memory = parser->ReadMemory(address, size);
-    if (!memory) {
+    auto result = TryReadMemory(address, size);
+    if (result.IsUnmapped()) {
         LOG(ERROR) << "Failed to read memory at address: 0x" << std::hex << address;
-        exit(1);
         return {};
     }
-    VLOG(1) << "Memory read at address: 0x" << std::hex << address << " size: " << std::dec << memory->size();
-    return *memory;
+    return std::move(result.data);
+}
+
+bool MinidumpContext::IsKnownUnmapped(uint64_t address, uint64_t size) const {
+    std::lock_guard<std::mutex> lock(*unmapped_mutex);
+    return unmapped_ranges.Contains(address, size);
+}
+
+void MinidumpContext::AddUnmapped(uint64_t address, uint64_t size) const {
+    std::lock_guard<std::mutex> lock(*unmapped_mutex);
+    unmapped_ranges.Add(address, size);
+}
+
+std::map<uint64_t, uint64_t> MinidumpContext::GetUnmappedRanges() const {
+    std::lock_guard<std::mutex> lock(*unmapped_mutex);
+    return unmapped_ranges.GetRanges();
+}
+
+ReadResult MinidumpContext::TryReadMemory(uint64_t address, size_t size) const {
+    ReadResult result;
+    if (IsKnownUnmapped(address)) {
+        VLOG(1) << "Address 0x" << std::hex << address << " is known to be unmapped";
+        return result;
+    }
+
+    result.data.resize(size);
+    const auto copied = region_index.Read(address, result.data.data(), size);
+    if (copied == 0) {
+        // Remember the whole gap up to the next region
+        const auto next_base = region_index.NextRegionBase(address);
+        AddUnmapped(address, next_base - address);
+        VLOG(1) << "Unmapped memory at 0x" << std::hex << address << ", gap ends at 0x" << next_base;
+        result.data.clear();
+        return result;
+    }
+    result.data.resize(copied);
+    result.status = copied == size ? ReadStatus::Ok : ReadStatus::Partial;
+    VLOG(1) << "Memory read at address: 0x" << std::hex << address << " size: " << std::dec << copied;
+    return result;
+}
+
+llvm::ArrayRef<uint8_t> MinidumpContext::ReadMemoryView(uint64_t address, size_t size) const {
+    // Region data points straight into the dump file mapped by the parser
+    auto memory = region_index.View(address, size);
+    if (memory.empty()) {
+        VLOG(1) << "No memory region for address: 0x" << std::hex << address;
+        return {};
+    }
+    VLOG(1) << "Memory view at address: 0x" << std::hex << address << " size: " << std::dec << memory.size();
+    return memory;
+}
+
+size_t MinidumpContext::ReadRanges(llvm::MutableArrayRef<MemoryRange> ranges) const {
+    const auto complete = region_index.ReadRanges(ranges);
+    VLOG(1) << "Batched read of " << ranges.size() << " ranges, " << complete << " complete";
+    return complete;
+}
+
+std::vector<ThreadContext> MinidumpContext::GetThreadContexts() const {
+    std::vector<ThreadContext> contexts;
+    const auto foreground_thread_id = parser->GetForegroundThreadId();
+    for (const auto& [id, thread] : parser->GetThreads()) {
+        if (!std::holds_alternative<udmpparser::Context64_t>(thread.Context)) {
+            VLOG(1) << "Skipping thread " << std::dec << id << " without a 64-bit context";
+            continue;
+        }
+        const auto& ctx64 = std::get<udmpparser::Context64_t>(thread.Context);
+        contexts.push_back({id, ctx64.Rip, ctx64.Rsp, thread.Teb});
+    }
+    std::stable_partition(contexts.begin(), contexts.end(), [&](const ThreadContext& context) {
+        return foreground_thread_id && context.id == *foreground_thread_id;
+    });
+    return contexts;
 }
 
 uint64_t MinidumpContext::GetThreadTebAddress() const {
@@ -1,8 +1,17 @@
 #pragma once
 
 #include "Disasm/XEDDisassembler.h"
+#include "Minidump/MemoryInfo.h"
+#include "Minidump/MemoryRegionIndex.h"
+#include "Minidump/UnmappedRangeCache.h"
 #include "third_party/udm_parser/src/lib/udmp-parser.h"
 
+#include <llvm/ADT/ArrayRef.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
 namespace MinidumpContext {
 
 class MinidumpContext {
@@ -11,11 +20,49 @@ public:
     bool Initialize();
     uint64_t GetInstructionPointer() const;
     uint64_t GetThreadTebAddress() const;
+
+    // Every thread with a 64-bit context, the foreground thread first
+    std::vector<ThreadContext> GetThreadContexts() const;
+
+    // Empty if the address is not in the dump, see TryReadMemory
     std::vector<uint8_t> ReadMemory(uint64_t address, size_t size) const;
 
+    // Read that reports unmapped and partial reads instead of failing.
+    // Gaps between dump regions are remembered, repeated reads of absent
+    // addresses don't touch the region index.
+    ReadResult TryReadMemory(uint64_t address, size_t size) const;
+
+    // Non-owning view into the mapped dump file, valid for the lifetime of
+    // this context. The view is truncated at the end of the containing
+    // memory block, empty if the address is not in the dump.
+    llvm::ArrayRef<uint8_t> ReadMemoryView(uint64_t address, size_t size) const;
+
+    // Fill a batch of ranges sorted by address, see MemoryRegionIndex::ReadRanges
+    size_t ReadRanges(llvm::MutableArrayRef<MemoryRange> ranges) const;
+
+    // Protection, region type and owning module of the address
+    MemoryInfo QueryMemory(uint64_t address) const;
+
+    const MemoryRegionIndex& GetRegionIndex() const { return region_index; }
+    const std::vector<ModuleInfo>& GetModules() const { return modules; }
+
+    // Ranges known to be absent from the dump, safe to use from several threads
+    bool IsKnownUnmapped(uint64_t address, uint64_t size = 1) const;
+    void AddUnmapped(uint64_t address, uint64_t size) const;
+    // Copy of the known ranges, start -> end (exclusive)
+    std::map<uint64_t, uint64_t> GetUnmappedRanges() const;
+
 private:
     std::unique_ptr<udmpparser::UserDumpParser> parser;
     std::string dump_path;
+    MemoryRegionIndex region_index;
+    std::vector<ModuleInfo> modules;
+    mutable UnmappedRangeCache unmapped_ranges;
+    // Reads may come from several threads, held by pointer to keep the context movable
+    std::unique_ptr<std::mutex> unmapped_mutex = std::make_unique<std::mutex>();
+
+    void BuildRegionIndex();
+    void BuildModuleList();
 };
 
 }  // namespace MinidumpContext
@@ -0,0 +1,117 @@
+#include "PEImage.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace MinidumpContext {
+
+namespace {
+    constexpr size_t kHeaderSize = 0x1000;
+    constexpr uint16_t kDosMagic = 0x5a4d;          // MZ
+    constexpr uint32_t kNtSignature = 0x00004550;   // PE\0\0
+    constexpr uint16_t kOptionalMagic32 = 0x10b;
+    constexpr uint16_t kOptionalMagic64 = 0x20b;
+    constexpr size_t kFileHeaderSize = 20;
+    constexpr size_t kSectionHeaderSize = 40;
+    constexpr uint32_t kIatDirectory = 12;
+
+    template <typename T>
+    bool Load(const std::vector<uint8_t>& data, size_t offset, T& value) {
+        if (offset > data.size() || data.size() - offset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return true;
+    }
+}
+
+bool ParsePEImage(ModuleInfo& module, const ImageReader& read) {
+    std::vector<uint8_t> headers(kHeaderSize);
+    headers.resize(read(module.base, headers.data(), headers.size()));
+
+    uint16_t dos_magic = 0;
+    uint32_t nt_offset = 0;
+    uint32_t signature = 0;
+    if (!Load(headers, 0, dos_magic) || dos_magic != kDosMagic ||
+        !Load(headers, 0x3c, nt_offset) ||
+        !Load(headers, nt_offset, signature) || signature != kNtSignature) {
+        VLOG(1) << "No PE headers for module " << module.name;
+        return false;
+    }
+
+    const size_t file_header = nt_offset + 4;
+    uint16_t section_count = 0;
+    uint16_t optional_size = 0;
+    uint16_t optional_magic = 0;
+    if (!Load(headers, file_header + 2, section_count) ||
+        !Load(headers, file_header + 16, optional_size) ||
+        !Load(headers, file_header + kFileHeaderSize, optional_magic)) {
+        LOG(WARNING) << "Truncated PE headers for module " << module.name;
+        return false;
+    }
+
+    // Data directories follow the fixed part of the optional header
+    const size_t optional_header = file_header + kFileHeaderSize;
+    size_t directories = 0;
+    uint32_t directory_count = 0;
+    if (optional_magic == kOptionalMagic64) {
+        Load(headers, optional_header + 108, directory_count);
+        directories = optional_header + 112;
+    } else if (optional_magic == kOptionalMagic32) {
+        Load(headers, optional_header + 92, directory_count);
+        directories = optional_header + 96;
+    } else {
+        LOG(WARNING) << "Unknown optional header magic 0x" << std::hex << optional_magic << " in " << module.name;
+        return false;
+    }
+
+    std::vector<SectionInfo> sections;
+    const size_t section_table = optional_header + optional_size;
+    for (uint16_t i = 0; i < section_count; i++) {
+        const size_t entry = section_table + i * kSectionHeaderSize;
+        char name[9] = {};
+        uint32_t virtual_size = 0;
+        uint32_t virtual_address = 0;
+        uint32_t raw_size = 0;
+        uint32_t characteristics = 0;
+        if (entry + kSectionHeaderSize > headers.size() ||
+            !Load(headers, entry + 8, virtual_size) ||
+            !Load(headers, entry + 12, virtual_address) ||
+            !Load(headers, entry + 16, raw_size) ||
+            !Load(headers, entry + 36, characteristics)) {
+            LOG(WARNING) << "Truncated section table in " << module.name;
+            break;
+        }
+        std::memcpy(name, headers.data() + entry, 8);
+
+        // Sections are mapped with their virtual size, clamp to the image
+        uint64_t size = virtual_size ? virtual_size : raw_size;
+        if (virtual_address >= module.size || size == 0) {
+            continue;
+        }
+        size = std::min<uint64_t>(size, module.size - virtual_address);
+        sections.push_back({name, module.base + virtual_address, size, characteristics});
+    }
+    std::sort(sections.begin(), sections.end(),
+              [](const SectionInfo& a, const SectionInfo& b) { return a.address < b.address; });
+
+    uint32_t iat_rva = 0;
+    uint32_t iat_size = 0;
+    if (directory_count > kIatDirectory &&
+        Load(headers, directories + kIatDirectory * 8, iat_rva) &&
+        Load(headers, directories + kIatDirectory * 8 + 4, iat_size) &&
+        iat_rva != 0 && iat_rva < module.size) {
+        module.iat_address = module.base + iat_rva;
+        module.iat_size = std::min<uint64_t>(iat_size, module.size - iat_rva);
+    }
+
+    module.sections = std::move(sections);
+    VLOG(1) << "Module " << module.name << ": " << std::dec << module.sections.size()
+            << " sections, IAT at 0x" << std::hex << module.iat_address << " size: 0x" << module.iat_size;
+    return true;
+}
+
+}  // namespace MinidumpContext
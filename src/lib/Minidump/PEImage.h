@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Minidump/MemoryInfo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace MinidumpContext {
+
+// Copies memory of the captured process, returns the number of bytes copied
+using ImageReader = std::function<size_t(uint64_t address, uint8_t* out, size_t size)>;
+
+// Parse the PE headers mapped at the module base and fill its section list
+// and import address table. Returns false if the module has no valid headers,
+// the module is left unchanged in that case.
+bool ParsePEImage(ModuleInfo& module, const ImageReader& read);
+
+}  // namespace MinidumpContext
@@ -0,0 +1,43 @@
+#include "UnmappedRangeCache.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace MinidumpContext {
+
+void UnmappedRangeCache::Add(uint64_t address, uint64_t size) {
+    if (size == 0) {
+        return;
+    }
+    uint64_t start = address;
+    uint64_t end = address + size < address ? UINT64_MAX : address + size;
+
+    // Merge with a range that starts before and reaches the new one
+    auto it = ranges.upper_bound(start);
+    if (it != ranges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= start) {
+            start = prev->first;
+            end = std::max(end, prev->second);
+            it = ranges.erase(prev);
+        }
+    }
+
+    // Swallow the ranges starting inside or right after the new one
+    while (it != ranges.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = ranges.erase(it);
+    }
+    ranges.emplace(start, end);
+}
+
+bool UnmappedRangeCache::Contains(uint64_t address, uint64_t size) const {
+    auto it = ranges.upper_bound(address);
+    if (it == ranges.begin()) {
+        return false;
+    }
+    --it;
+    return address - it->first < it->second - it->first && size <= it->second - address;
+}
+
+}  // namespace MinidumpContext
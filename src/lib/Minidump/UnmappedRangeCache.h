@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+
+namespace MinidumpContext {
+
+// Negative cache of address ranges known to be absent from the memory source.
+// Overlapping and adjacent ranges are merged, so a lookup is one map search.
+class UnmappedRangeCache {
+public:
+    // Record [address, address + size) as unmapped, clamped to the address space
+    void Add(uint64_t address, uint64_t size);
+
+    // Whole range is known to be unmapped
+    bool Contains(uint64_t address, uint64_t size = 1) const;
+
+    void Clear() { ranges.clear(); }
+    size_t GetRangeCount() const { return ranges.size(); }
+    const std::map<uint64_t, uint64_t>& GetRanges() const { return ranges; }
+
+private:
+    std::map<uint64_t, uint64_t> ranges; // start -> end (exclusive)
+};
+
+}  // namespace MinidumpContext
@@ -0,0 +1,364 @@
+#include "Snapshot.h"
+#include "Minidump/PEImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+namespace Snapshot {
+
+namespace {
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Collects pages in address order and stores each distinct page content once
+class PageBuilder {
+public:
+    void AddBytes(uint64_t address, const uint8_t* bytes, uint64_t size, uint32_t protect) {
+        while (size > 0) {
+            const uint64_t page_addr = address & ~(kSnapshotPageSize - 1);
+            if (page_addr != current_addr) {
+                Flush();
+                current_addr = page_addr;
+                current_protect = protect;
+                std::fill(current.begin(), current.end(), 0);
+                has_current = true;
+            }
+            const uint64_t offset = address - page_addr;
+            const uint64_t chunk = std::min(kSnapshotPageSize - offset, size);
+            std::memcpy(current.data() + offset, bytes, chunk);
+            address += chunk;
+            bytes += chunk;
+            size -= chunk;
+        }
+    }
+
+    void Flush() {
+        if (!has_current) {
+            return;
+        }
+        has_current = false;
+
+        const std::string_view content(reinterpret_cast<const char*>(current.data()), current.size());
+        const auto hash = std::hash<std::string_view>{}(content);
+        uint32_t data_index = 0;
+        bool found = false;
+        auto range = unique_pages.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (std::memcmp(data.data() + it->second * kSnapshotPageSize, current.data(), kSnapshotPageSize) == 0) {
+                data_index = it->second;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            data_index = static_cast<uint32_t>(data.size() / kSnapshotPageSize);
+            data.insert(data.end(), current.begin(), current.end());
+            unique_pages.emplace(hash, data_index);
+        }
+        pages.push_back({current_addr, data_index, current_protect});
+    }
+
+    std::vector<SnapshotPageEntry> pages;
+    std::vector<uint8_t> data;
+
+private:
+    std::vector<uint8_t> current = std::vector<uint8_t>(kSnapshotPageSize);
+    uint64_t current_addr = 0;
+    uint32_t current_protect = 0;
+    bool has_current = false;
+    std::unordered_multimap<size_t, uint32_t> unique_pages;
+};
+
+}  // namespace
+
+bool WriteSnapshot(const std::string& path,
+                   const MinidumpContext::MemoryRegionIndex& regions,
+                   const std::vector<MinidumpContext::ModuleInfo>& modules,
+                   uint64_t instruction_pointer,
+                   uint64_t teb_address) {
+    LOG(INFO) << "Writing snapshot to: " << path;
+
+    PageBuilder builder;
+    std::vector<SnapshotRegionEntry> region_entries;
+    for (const auto& region : regions.GetRegions()) {
+        builder.AddBytes(region.base, region.data, region.size, region.protect);
+        region_entries.push_back({region.base, region.size, region.protect, region.type});
+    }
+    builder.Flush();
+
+    std::vector<SnapshotModuleEntry> module_entries;
+    for (const auto& module : modules) {
+        SnapshotModuleEntry entry = {};
+        entry.base = module.base;
+        entry.size = module.size;
+        std::strncpy(entry.name, module.name.c_str(), sizeof(entry.name) - 1);
+        module_entries.push_back(entry);
+    }
+    std::sort(module_entries.begin(), module_entries.end(),
+              [](const SnapshotModuleEntry& a, const SnapshotModuleEntry& b) { return a.base < b.base; });
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.page_size = kSnapshotPageSize;
+    header.instruction_pointer = instruction_pointer;
+    header.teb_address = teb_address;
+    header.page_count = builder.pages.size();
+    header.region_count = region_entries.size();
+    header.data_page_count = builder.data.size() / kSnapshotPageSize;
+    header.page_table_offset = sizeof(SnapshotHeader);
+    header.region_table_offset = header.page_table_offset + header.page_count * sizeof(SnapshotPageEntry);
+    header.module_count = module_entries.size();
+    header.module_table_offset = header.region_table_offset + header.region_count * sizeof(SnapshotRegionEntry);
+    header.data_offset = AlignUp(header.module_table_offset + header.module_count * sizeof(SnapshotModuleEntry),
+                                 kSnapshotPageSize);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG(ERROR) << "Could not open snapshot file: " << path;
+        return false;
+    }
+
+    const std::vector<char> padding(header.data_offset - header.module_table_offset -
+                                    header.module_count * sizeof(SnapshotModuleEntry));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(builder.pages.data()), builder.pages.size() * sizeof(SnapshotPageEntry));
+    file.write(reinterpret_cast<const char*>(region_entries.data()), region_entries.size() * sizeof(SnapshotRegionEntry));
+    file.write(reinterpret_cast<const char*>(module_entries.data()), module_entries.size() * sizeof(SnapshotModuleEntry));
+    file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char*>(builder.data.data()), builder.data.size());
+    if (!file) {
+        LOG(ERROR) << "Failed to write snapshot file: " << path;
+        return false;
+    }
+
+    LOG(INFO) << "Snapshot written: " << header.page_count << " pages, "
+              << header.data_page_count << " unique, " << header.region_count << " regions, "
+              << header.module_count << " modules";
+    return true;
+}
+
+SnapshotFile::~SnapshotFile() {
+    Close();
+}
+
+void SnapshotFile::Close() {
+    if (mapping) {
+        munmap(const_cast<uint8_t*>(mapping), mapping_size);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    pages = nullptr;
+    regions = nullptr;
+    data = nullptr;
+    modules.clear();
+}
+
+bool SnapshotFile::Open(const std::string& path) {
+    Close();
+    LOG(INFO) << "Opening snapshot file: " << path;
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG(ERROR) << "Could not open snapshot file: " << path;
+        return false;
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        LOG(ERROR) << "Snapshot file is too small: " << path;
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        LOG(ERROR) << "Could not map snapshot file: " << path;
+        return false;
+    }
+    mapping = static_cast<const uint8_t*>(view);
+    mapping_size = st.st_size;
+    header = reinterpret_cast<const SnapshotHeader*>(mapping);
+
+    if (std::memcmp(header->magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+        header->version != kSnapshotVersion ||
+        header->page_size != kSnapshotPageSize) {
+        LOG(ERROR) << "Unsupported snapshot file: " << path;
+        Close();
+        return false;
+    }
+
+    if (!ValidateLayout()) {
+        LOG(ERROR) << "Truncated or corrupt snapshot file: " << path;
+        Close();
+        return false;
+    }
+
+    pages = reinterpret_cast<const SnapshotPageEntry*>(mapping + header->page_table_offset);
+    regions = reinterpret_cast<const SnapshotRegionEntry*>(mapping + header->region_table_offset);
+    data = mapping + header->data_offset;
+
+    // The module table is tiny, keep it in the same form the other sources use
+    const auto* module_entries = reinterpret_cast<const SnapshotModuleEntry*>(mapping + header->module_table_offset);
+    for (uint64_t i = 0; i < header->module_count; i++) {
+        const auto& entry = module_entries[i];
+        modules.push_back({entry.base, entry.size, std::string(entry.name, strnlen(entry.name, sizeof(entry.name)))});
+    }
+    const auto read = [this](uint64_t address, uint8_t* out, size_t size) {
+        size_t copied = 0;
+        while (copied < size) {
+            const auto view = ReadMemoryView(address + copied, size - copied);
+            if (view.empty()) {
+                break;
+            }
+            std::memcpy(out + copied, view.data(), view.size());
+            copied += view.size();
+        }
+        return copied;
+    };
+    for (auto& module : modules) {
+        MinidumpContext::ParsePEImage(module, read);
+    }
+
+    VLOG(1) << "Snapshot opened: " << header->page_count << " pages, "
+            << header->region_count << " regions";
+    return true;
+}
+
+bool SnapshotFile::ValidateLayout() const {
+    // Tables are read in place, each must lie inside the file and be aligned
+    // for its entries. Counts are checked by division so they can't overflow.
+    const auto table_fits = [this](uint64_t offset, uint64_t count, size_t entry_size, size_t alignment) {
+        return offset % alignment == 0 && offset <= mapping_size &&
+               count <= (mapping_size - offset) / entry_size;
+    };
+    if (!table_fits(header->page_table_offset, header->page_count,
+                    sizeof(SnapshotPageEntry), alignof(SnapshotPageEntry)) ||
+        !table_fits(header->region_table_offset, header->region_count,
+                    sizeof(SnapshotRegionEntry), alignof(SnapshotRegionEntry)) ||
+        !table_fits(header->module_table_offset, header->module_count,
+                    sizeof(SnapshotModuleEntry), alignof(SnapshotModuleEntry)) ||
+        !table_fits(header->data_offset, header->data_page_count, kSnapshotPageSize, 1)) {
+        VLOG(1) << "Snapshot table outside of the file";
+        return false;
+    }
+
+    // Lookups binary search the page and region tables, and every page must
+    // point at stored data
+    const auto* page_entries = reinterpret_cast<const SnapshotPageEntry*>(mapping + header->page_table_offset);
+    for (uint64_t i = 0; i < header->page_count; i++) {
+        const auto& page = page_entries[i];
+        if (page.address % kSnapshotPageSize != 0 || page.data_index >= header->data_page_count ||
+            (i > 0 && page.address <= page_entries[i - 1].address)) {
+            VLOG(1) << "Invalid snapshot page entry " << std::dec << i;
+            return false;
+        }
+    }
+    const auto* region_entries = reinterpret_cast<const SnapshotRegionEntry*>(mapping + header->region_table_offset);
+    for (uint64_t i = 1; i < header->region_count; i++) {
+        if (region_entries[i].base < region_entries[i - 1].base) {
+            VLOG(1) << "Snapshot region table is not sorted at entry " << std::dec << i;
+            return false;
+        }
+    }
+    return true;
+}
+
+llvm::ArrayRef<SnapshotPageEntry> SnapshotFile::GetPages() const {
+    return llvm::ArrayRef<SnapshotPageEntry>(pages, header ? header->page_count : 0);
+}
+
+llvm::ArrayRef<SnapshotRegionEntry> SnapshotFile::GetRegions() const {
+    return llvm::ArrayRef<SnapshotRegionEntry>(regions, header ? header->region_count : 0);
+}
+
+const uint8_t* SnapshotFile::PageData(const SnapshotPageEntry& page) const {
+    return data + static_cast<uint64_t>(page.data_index) * kSnapshotPageSize;
+}
+
+const SnapshotPageEntry* SnapshotFile::FindPage(uint64_t address) const {
+    const auto all_pages = GetPages();
+    const uint64_t page_addr = address & ~(kSnapshotPageSize - 1);
+    auto it = std::lower_bound(all_pages.begin(), all_pages.end(), page_addr,
+                               [](const SnapshotPageEntry& page, uint64_t addr) { return page.address < addr; });
+    if (it == all_pages.end() || it->address != page_addr) {
+        return nullptr;
+    }
+    return it;
+}
+
+llvm::ArrayRef<uint8_t> SnapshotFile::ReadMemoryView(uint64_t address, size_t size) const {
+    const auto* page = FindPage(address);
+    if (!page) {
+        return {};
+    }
+
+    const uint64_t offset = address - page->address;
+    const uint8_t* start = PageData(*page) + offset;
+    uint64_t available = kSnapshotPageSize - offset;
+
+    // Extend the view while the next page is both adjacent and stored next
+    const auto* end = pages + header->page_count;
+    for (const auto* next = page + 1; available < size && next != end; ++next) {
+        const auto* prev = next - 1;
+        if (next->address != prev->address + kSnapshotPageSize || next->data_index != prev->data_index + 1) {
+            break;
+        }
+        available += kSnapshotPageSize;
+    }
+
+    return llvm::ArrayRef<uint8_t>(start, std::min<uint64_t>(available, size));
+}
+
+MinidumpContext::MemoryInfo SnapshotFile::QueryMemory(uint64_t address) const {
+    MinidumpContext::MemoryInfo info;
+    if (const auto* page = FindPage(address)) {
+        info.mapped = true;
+        info.protect = page->protect;
+    }
+
+    const auto all_regions = GetRegions();
+    auto it = std::upper_bound(all_regions.begin(), all_regions.end(), address,
+                               [](uint64_t addr, const SnapshotRegionEntry& region) { return addr < region.base; });
+    if (it != all_regions.begin() && address - std::prev(it)->base < std::prev(it)->size) {
+        info.type = std::prev(it)->type;
+        info.region_base = std::prev(it)->base;
+        info.region_size = std::prev(it)->size;
+    }
+
+    info.module = MinidumpContext::FindModule(modules, address);
+    if (info.module) {
+        info.section = MinidumpContext::FindSection(*info.module, address);
+    }
+    return info;
+}
+
+std::vector<uint8_t> SnapshotFile::ReadMemory(uint64_t address, size_t size) const {
+    std::vector<uint8_t> memory;
+    memory.reserve(size);
+    while (memory.size() < size) {
+        auto view = ReadMemoryView(address, size - memory.size());
+        if (view.empty()) {
+            break;
+        }
+        memory.insert(memory.end(), view.begin(), view.end());
+        address += view.size();
+    }
+    return memory;
+}
+
+}  // namespace Snapshot
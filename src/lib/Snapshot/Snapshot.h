@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Minidump/MemoryInfo.h"
+#include "Minidump/MemoryRegionIndex.h"
+#include "Prebuilt/Utils.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+
+namespace Snapshot {
+
+// On-disk layout, all offsets are relative to the start of the file:
+//
+//   SnapshotHeader
+//   SnapshotPageEntry[page_count]      sorted by address
+//   SnapshotRegionEntry[region_count]  sorted by base
+//   SnapshotModuleEntry[module_count]  sorted by base
+//   padding up to the next page boundary
+//   page data[data_page_count]         deduplicated, page aligned
+//
+// The file is designed to be used straight from the mapping, nothing is
+// parsed or copied on open.
+
+constexpr char kSnapshotMagic[8] = {'R', 'C', 'Y', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t kSnapshotVersion = 2;
+constexpr uint64_t kSnapshotPageSize = PREBUILT_MEMORY_CELL_SIZE;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint64_t instruction_pointer;
+    uint64_t teb_address;
+    uint64_t page_count;
+    uint64_t region_count;
+    uint64_t data_page_count;
+    uint64_t page_table_offset;
+    uint64_t region_table_offset;
+    uint64_t data_offset;
+    uint64_t module_count;
+    uint64_t module_table_offset;
+};
+
+struct SnapshotPageEntry {
+    uint64_t address;
+    uint32_t data_index;    // Index into the deduplicated page data
+    uint32_t protect;
+};
+
+struct SnapshotRegionEntry {
+    uint64_t base;
+    uint64_t size;
+    uint32_t protect;
+    uint32_t type;
+};
+
+struct SnapshotModuleEntry {
+    uint64_t base;
+    uint64_t size;
+    char name[240];     // Null terminated, truncated if longer
+};
+
+// Write the regions, modules and the foreground thread context into a snapshot file
+bool WriteSnapshot(const std::string& path,
+                   const MinidumpContext::MemoryRegionIndex& regions,
+                   const std::vector<MinidumpContext::ModuleInfo>& modules,
+                   uint64_t instruction_pointer,
+                   uint64_t teb_address);
+
+// Read-only snapshot backed by a single mapping of the file
+class SnapshotFile {
+public:
+    SnapshotFile() = default;
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    bool Open(const std::string& path);
+
+    uint64_t GetInstructionPointer() const { return header->instruction_pointer; }
+    uint64_t GetThreadTebAddress() const { return header->teb_address; }
+
+    // Page containing the address or nullptr
+    const SnapshotPageEntry* FindPage(uint64_t address) const;
+
+    // Non-owning view into the mapping. Follows into the next page as long as
+    // its data is stored right after the current one, empty if not mapped.
+    llvm::ArrayRef<uint8_t> ReadMemoryView(uint64_t address, size_t size) const;
+
+    // Copy memory across page boundaries, stops at the first unmapped page
+    std::vector<uint8_t> ReadMemory(uint64_t address, size_t size) const;
+
+    // Protection, region type and owning module of the address
+    MinidumpContext::MemoryInfo QueryMemory(uint64_t address) const;
+
+    llvm::ArrayRef<SnapshotPageEntry> GetPages() const;
+    llvm::ArrayRef<SnapshotRegionEntry> GetRegions() const;
+    const std::vector<MinidumpContext::ModuleInfo>& GetModules() const { return modules; }
+
+private:
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    const SnapshotHeader* header = nullptr;
+    const SnapshotPageEntry* pages = nullptr;
+    const SnapshotRegionEntry* regions = nullptr;
+    const uint8_t* data = nullptr;
+    std::vector<MinidumpContext::ModuleInfo> modules;
+
+    const uint8_t* PageData(const SnapshotPageEntry& page) const;
+    // Table bounds and page entries checked against the mapping
+    bool ValidateLayout() const;
+    void Close();
+};
+
+}  // namespace Snapshot
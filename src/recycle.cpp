@@ -1,15 +1,40 @@
 #include "JIT/JITEngine.h"
 #include "JIT/JITRuntime.h"
 #include "Minidump/MinidumpContext.h"
+#include "Snapshot/Snapshot.h"
+#include "Discovery/DiscoverySession.h"
+#include "Discovery/JumpTable.h"
+#include "Discovery/LinearSweep.h"
+#include "Discovery/StaticDiscovery.h"
+#include "Discovery/ThreadPool.h"
 #include "Disasm/BasicBlockDisassembler.h"
 #include "Lift/BasicBlockLifter.h"
+#include "Lift/DiskLiftCache.h"
+#include "Lift/LiftingContext.h"
+#include "Lift/LiftWorkerPool.h"
+#include "Lift/LiftedBlockMap.h"
 #include "Prebuilt/Utils.h"
 #include "BitcodeManipulation/BitcodeManipulation.h"
 
 #include "remill/Arch/X86/Runtime/State.h"
 
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <fstream>
 #include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/Format.h>
 #include <llvm/IR/PassManager.h>
@@ -32,9 +57,26 @@
 using namespace llvm;
 
 // Define command line flags
-DEFINE_string(minidump, "", "Path to the minidump file (REQUIRED)");
+DEFINE_string(minidump, "", "Path to the minidump file (REQUIRED unless --snapshot is given)");
+DEFINE_string(snapshot, "", "Path to a snapshot file written by --write_snapshot, used instead of --minidump");
+DEFINE_int32(pid, 0, "Lift from a running local process instead of a dump, the process is stopped while attached");
+DEFINE_uint64(live_cache_pages, 4096, "Number of pages kept in the live process page cache");
+DEFINE_string(write_snapshot, "", "Convert --minidump into a snapshot file at this path and exit");
 DEFINE_uint64(stop_addr, 0, "Address to stop execution at (REQUIRED)");
+DEFINE_uint64(read_ahead_max_pages, 8, "Maximum number of neighbouring pages prefetched on a missing memory page, 0 disables read-ahead");
+DEFINE_uint64(preload_max_pages, 512, "Maximum number of module code, read-only data and import table pages loaded before the first run, 0 disables preloading");
 DEFINE_uint32(max_translations, 50, "Maximum number of translations to perform");
+DEFINE_uint32(static_max_blocks, 0, "Maximum number of blocks found by static discovery and lifted before the first run, 0 disables static discovery");
+DEFINE_uint32(superblock_max_instructions, 0, "Decode past direct jumps and calls and lift up to this many instructions as one trace, 0 lifts single basic blocks");
+DEFINE_bool(lift_functions, false, "Lift everything reachable from a missing block through direct branches as one trace, callees are still lifted on their own");
+DEFINE_uint32(lift_threads, 1, "Worker threads lifting the pending missing blocks of an iteration together, each with its own LLVM context; 1 lifts them one per iteration, 0 uses one per hardware thread. Not supported with --lift_functions");
+DEFINE_string(lift_cache_dir, "", "Directory of lifted blocks kept across runs, reused when the same code is lifted again; empty disables the cache");
+DEFINE_uint64(lift_cache_max_mb, 1024, "Size limit of --lift_cache_dir in MiB, the least recently used blocks are dropped beyond it");
+DEFINE_bool(strip_unreachable, true, "Remove semantics and runtime helpers no lifted block reaches from the merged module before optimizing it");
+DEFINE_bool(sweep_code, false, "Pre-decode every executable module section on --discovery_threads workers before lifting");
+DEFINE_bool(all_threads, false, "Lift the code reachable from every thread in the dump concurrently, then exit");
+DEFINE_uint32(discovery_threads, 0, "Worker threads for --all_threads and --sweep_code, 0 uses one per hardware thread");
+DEFINE_uint32(max_blocks_per_thread, 1000, "Maximum number of blocks lifted for each thread with --all_threads");
 DEFINE_bool(help_all, false, "Show all help options");
 
 namespace Recycle {
@@ -49,32 +91,94 @@ public:
         // Flags should already be parsed in main()
         
         // Validate required flags
-        if (FLAGS_minidump.empty()) {
+        if (FLAGS_minidump.empty() && FLAGS_snapshot.empty() && FLAGS_pid == 0) {
+            gflags::ShowUsageWithFlagsRestrict(argv[0], "src/recycle.cpp");
+            throw std::runtime_error("--minidump, --snapshot or --pid is required");
+        }
+
+        if (!FLAGS_write_snapshot.empty() && FLAGS_minidump.empty()) {
             gflags::ShowUsageWithFlagsRestrict(argv[0], "src/recycle.cpp");
-            throw std::runtime_error("--minidump is required");
+            throw std::runtime_error("--write_snapshot requires --minidump");
         }
         
-        if (FLAGS_stop_addr == 0) {
+        if (FLAGS_stop_addr == 0 && FLAGS_write_snapshot.empty() && !FLAGS_all_threads) {
             gflags::ShowUsageWithFlagsRestrict(argv[0], "src/recycle.cpp");
             throw std::runtime_error("--stop_addr is required");
         }
+
+        if (FLAGS_lift_functions && FLAGS_lift_threads != 1) {
+            gflags::ShowUsageWithFlagsRestrict(argv[0], "src/recycle.cpp");
+            throw std::runtime_error("--lift_functions lifts one trace per iteration, "
+                                     "it can't be combined with --lift_threads");
+        }
         
         // Store values in class members
         minidumpPath = FLAGS_minidump;
+        snapshotPath = FLAGS_snapshot;
+        writeSnapshotPath = FLAGS_write_snapshot;
+        pid = FLAGS_pid;
+        liveCachePages = FLAGS_live_cache_pages;
         stopAddr = FLAGS_stop_addr;
         // print the stop address in hex
         LOG(INFO) << "Stop address: 0x" << std::hex << stopAddr;
         maxTranslations = FLAGS_max_translations;
+        readAheadMaxPages = FLAGS_read_ahead_max_pages;
+        preloadMaxPages = FLAGS_preload_max_pages;
+        staticMaxBlocks = FLAGS_static_max_blocks;
+        sweepCode = FLAGS_sweep_code;
+        stripUnreachable = FLAGS_strip_unreachable;
+        superblockMaxInstructions = FLAGS_superblock_max_instructions;
+        liftFunctions = FLAGS_lift_functions;
+        liftThreads = FLAGS_lift_threads;
+        liftCacheDir = FLAGS_lift_cache_dir;
+        liftCacheMaxBytes = FLAGS_lift_cache_max_mb << 20;
+        allThreads = FLAGS_all_threads;
+        discoveryThreads = FLAGS_discovery_threads;
+        maxBlocksPerThread = FLAGS_max_blocks_per_thread;
     }
     
     std::string getMinidumpPath() const { return minidumpPath; }
+    std::string getSnapshotPath() const { return snapshotPath; }
+    std::string getWriteSnapshotPath() const { return writeSnapshotPath; }
+    pid_t getPid() const { return pid; }
+    size_t getLiveCachePages() const { return liveCachePages; }
     uint64_t getStopAddr() const { return stopAddr; }
     size_t getMaxTranslations() const { return maxTranslations; }
+    size_t getReadAheadMaxPages() const { return readAheadMaxPages; }
+    size_t getPreloadMaxPages() const { return preloadMaxPages; }
+    size_t getStaticMaxBlocks() const { return staticMaxBlocks; }
+    bool getSweepCode() const { return sweepCode; }
+    bool getStripUnreachable() const { return stripUnreachable; }
+    size_t getSuperblockMaxInstructions() const { return superblockMaxInstructions; }
+    bool getLiftFunctions() const { return liftFunctions; }
+    size_t getLiftThreads() const { return liftThreads; }
+    std::string getLiftCacheDir() const { return liftCacheDir; }
+    uint64_t getLiftCacheMaxBytes() const { return liftCacheMaxBytes; }
+    bool getAllThreads() const { return allThreads; }
+    size_t getDiscoveryThreads() const { return discoveryThreads; }
+    size_t getMaxBlocksPerThread() const { return maxBlocksPerThread; }
     
 private:
     std::string minidumpPath;
+    std::string snapshotPath;
+    std::string writeSnapshotPath;
+    pid_t pid = 0;
+    size_t liveCachePages = 4096;
     uint64_t stopAddr = 0;  // 0x140001862
     size_t maxTranslations = 50;
+    size_t readAheadMaxPages = 8;
+    size_t preloadMaxPages = 512;
+    size_t staticMaxBlocks = 0;
+    bool sweepCode = false;
+    bool stripUnreachable = true;
+    size_t superblockMaxInstructions = 0;
+    bool liftFunctions = false;
+    size_t liftThreads = 1;
+    std::string liftCacheDir;
+    uint64_t liftCacheMaxBytes = 1024ull << 20;
+    bool allThreads = false;
+    size_t discoveryThreads = 0;
+    size_t maxBlocksPerThread = 1000;
 };
 
 // Memory reader interface to abstract memory access
@@ -84,12 +188,75 @@ public:
     
     // Read memory from the specified address
     virtual std::vector<uint8_t> ReadMemory(uint64_t address, size_t size) const = 0;
+
+    // Read memory without copying, the view stays valid until ReleaseViews
+    // is called. The view may be shorter than requested, empty on failure
+    virtual llvm::ArrayRef<uint8_t> ReadMemoryView(uint64_t address, size_t size) const = 0;
+
+    // Invalidate every view taken so far, for readers that keep memory alive
+    // for them. Called once nothing holds a view anymore
+    virtual void ReleaseViews() const {}
+
+    // Fill a batch of ranges sorted by address into caller-provided buffers.
+    // Returns the number of ranges that were read completely
+    virtual size_t ReadRanges(llvm::MutableArrayRef<MinidumpContext::MemoryRange> ranges) const {
+        size_t complete = 0;
+        for (auto& range : ranges) {
+            range.bytes_read = 0;
+            while (range.bytes_read < range.size) {
+                auto view = ReadMemoryView(range.address + range.bytes_read, range.size - range.bytes_read);
+                if (view.empty()) {
+                    break;
+                }
+                std::copy(view.begin(), view.end(), range.buffer + range.bytes_read);
+                range.bytes_read += view.size();
+            }
+            if (range.bytes_read == range.size) {
+                complete++;
+            }
+        }
+        return complete;
+    }
+    
+    // Get protection, region type and owning module of the address
+    virtual MinidumpContext::MemoryInfo QueryMemory(uint64_t address) const = 0;
+
+    // Loaded modules sorted by base, with PE sections where headers were found
+    virtual const std::vector<MinidumpContext::ModuleInfo>& GetModules() const = 0;
     
     // Get the entry point (instruction pointer)
     virtual uint64_t GetEntryPoint() const = 0;
     
     // Get thread TEB address if available
     virtual uint64_t GetThreadTebAddress() const = 0;
+
+    // Threads that can be lifted from, sources without thread lists only
+    // know the current one
+    virtual std::vector<MinidumpContext::ThreadContext> GetThreadContexts() const {
+        return {{0, GetEntryPoint(), 0, GetThreadTebAddress()}};
+    }
+
+    // Negative cache of ranges known to be absent from the source, the one
+    // cache every stage of the pipeline consults. Safe to use from several threads
+    virtual bool IsKnownUnmapped(uint64_t address, uint64_t size = 1) const {
+        std::lock_guard<std::mutex> lock(unmapped_mutex);
+        return unmapped_ranges.Contains(address, size);
+    }
+
+    virtual void AddUnmapped(uint64_t address, uint64_t size) const {
+        std::lock_guard<std::mutex> lock(unmapped_mutex);
+        unmapped_ranges.Add(address, size);
+    }
+
+    // Copy of the known ranges, start -> end (exclusive)
+    virtual std::map<uint64_t, uint64_t> GetUnmappedRanges() const {
+        std::lock_guard<std::mutex> lock(unmapped_mutex);
+        return unmapped_ranges.GetRanges();
+    }
+
+private:
+    mutable std::mutex unmapped_mutex;
+    mutable MinidumpContext::UnmappedRangeCache unmapped_ranges;
 };
 
 // Minidump implementation of the memory reader interface
@@ -104,6 +271,22 @@ public:
     std::vector<uint8_t> ReadMemory(uint64_t address, size_t size) const override {
         return minidump.ReadMemory(address, size);
     }
+
+    llvm::ArrayRef<uint8_t> ReadMemoryView(uint64_t address, size_t size) const override {
+        return minidump.ReadMemoryView(address, size);
+    }
+
+    size_t ReadRanges(llvm::MutableArrayRef<MinidumpContext::MemoryRange> ranges) const override {
+        return minidump.ReadRanges(ranges);
+    }
+
+    MinidumpContext::MemoryInfo QueryMemory(uint64_t address) const override {
+        return minidump.QueryMemory(address);
+    }
+
+    const std::vector<MinidumpContext::ModuleInfo>& GetModules() const override {
+        return minidump.GetModules();
+    }
     
     uint64_t GetEntryPoint() const override {
         return minidump.GetInstructionPointer();
@@ -112,11 +295,430 @@ public:
     uint64_t GetThreadTebAddress() const override {
         return minidump.GetThreadTebAddress();
     }
+
+    std::vector<MinidumpContext::ThreadContext> GetThreadContexts() const override {
+        return minidump.GetThreadContexts();
+    }
+
+    // The context records the gaps between dump regions it runs into, share its cache
+    bool IsKnownUnmapped(uint64_t address, uint64_t size = 1) const override {
+        return minidump.IsKnownUnmapped(address, size);
+    }
+
+    void AddUnmapped(uint64_t address, uint64_t size) const override {
+        minidump.AddUnmapped(address, size);
+    }
+
+    std::map<uint64_t, uint64_t> GetUnmappedRanges() const override {
+        return minidump.GetUnmappedRanges();
+    }
+
+    const MinidumpContext::MinidumpContext& GetMinidump() const {
+        return minidump;
+    }
     
 private:
     MinidumpContext::MinidumpContext minidump;
 };
 
+// Snapshot implementation of the memory reader interface, the file is
+// mapped once and used in place so opening does not depend on dump size
+class SnapshotMemoryReader : public MemoryReader {
+public:
+    SnapshotMemoryReader(const std::string& snapshotPath) {
+        if (!snapshot.Open(snapshotPath)) {
+            throw std::runtime_error("Failed to open snapshot file");
+        }
+    }
+
+    std::vector<uint8_t> ReadMemory(uint64_t address, size_t size) const override {
+        return snapshot.ReadMemory(address, size);
+    }
+
+    llvm::ArrayRef<uint8_t> ReadMemoryView(uint64_t address, size_t size) const override {
+        return snapshot.ReadMemoryView(address, size);
+    }
+
+    MinidumpContext::MemoryInfo QueryMemory(uint64_t address) const override {
+        return snapshot.QueryMemory(address);
+    }
+
+    const std::vector<MinidumpContext::ModuleInfo>& GetModules() const override {
+        return snapshot.GetModules();
+    }
+
+    uint64_t GetEntryPoint() const override {
+        return snapshot.GetInstructionPointer();
+    }
+
+    uint64_t GetThreadTebAddress() const override {
+        return snapshot.GetThreadTebAddress();
+    }
+
+private:
+    Snapshot::SnapshotFile snapshot;
+};
+
+// Live Linux process implementation of the memory reader interface. The
+// process is stopped with ptrace for the lifetime of the reader, memory is
+// pulled with batched process_vm_readv calls through a page-granular LRU cache
+class LiveProcessMemoryReader : public MemoryReader {
+public:
+    LiveProcessMemoryReader(pid_t pid_, size_t cache_pages_)
+        : pid(pid_), cache_capacity(std::max<size_t>(cache_pages_, 1)) {
+        if (ptrace(PTRACE_ATTACH, pid, nullptr, nullptr) == -1) {
+            throw std::runtime_error("Failed to attach to process " + std::to_string(pid));
+        }
+
+        int status = 0;
+        if (waitpid(pid, &status, __WALL) == -1 || !WIFSTOPPED(status)) {
+            ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
+            throw std::runtime_error("Process " + std::to_string(pid) + " did not stop after attach");
+        }
+
+        user_regs_struct regs = {};
+        if (ptrace(PTRACE_GETREGS, pid, nullptr, &regs) == -1) {
+            ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
+            throw std::runtime_error("Failed to read registers of process " + std::to_string(pid));
+        }
+        instruction_pointer = regs.rip;
+        // Linux keeps thread-local storage in fs, the pipeline only seeds gs
+        gs_base = regs.gs_base;
+        LoadMappings();
+        LOG(INFO) << "Attached to process " << std::dec << pid << ", rip: 0x" << std::hex << instruction_pointer;
+    }
+
+    ~LiveProcessMemoryReader() override {
+        LOG(INFO) << "Live page cache: " << std::dec << hits << " hits, " << misses << " misses, "
+                  << pinned.size() << " pinned pages, " << GetUnmappedRanges().size() << " unreadable ranges";
+        ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
+    }
+
+    std::vector<uint8_t> ReadMemory(uint64_t address, size_t size) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<uint8_t> memory(size);
+        memory.resize(CopyMemory(address, memory.data(), size, true));
+        return memory;
+    }
+
+    // Views pin the pages they point into until ReleaseViews, the process is
+    // stopped so pinned pages never go stale. A view within one page points
+    // into it, a longer one gets a contiguous copy that is kept as well. The
+    // view ends early only at the first unreadable page
+    llvm::ArrayRef<uint8_t> ReadMemoryView(uint64_t address, size_t size) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        const uint64_t page_addr = address & ~(kPageSize - 1);
+        const uint64_t offset = address - page_addr;
+        if (size <= kPageSize - offset) {
+            const auto* page = PinPage(page_addr);
+            if (!page) {
+                return {};
+            }
+            return llvm::ArrayRef<uint8_t>(page->data() + offset, size);
+        }
+
+        auto spans_at = spans.equal_range(address);
+        for (auto it = spans_at.first; it != spans_at.second; ++it) {
+            if (it->second.size() >= size) {
+                return llvm::ArrayRef<uint8_t>(it->second.data(), size);
+            }
+        }
+        std::vector<uint8_t> span(size);
+        span.resize(CopyMemory(address, span.data(), size, true));
+        if (span.empty()) {
+            return {};
+        }
+        for (auto it = spans_at.first; it != spans_at.second; ++it) {
+            if (it->second.size() >= span.size()) {
+                return llvm::ArrayRef<uint8_t>(it->second.data(), span.size());
+            }
+        }
+        const auto& kept = spans.emplace(address, std::move(span))->second;
+        return llvm::ArrayRef<uint8_t>(kept.data(), kept.size());
+    }
+
+    // Pinned pages go back into the LRU, where they count against the cache
+    // size again, and the copies made for longer views are freed
+    void ReleaseViews() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        VLOG(1) << "Releasing " << std::dec << pinned.size() << " pinned pages, " << spans.size() << " spans";
+        for (auto& [page_addr, data] : pinned) {
+            InsertPage(page_addr, std::move(data));
+        }
+        pinned.clear();
+        spans.clear();
+    }
+
+    size_t ReadRanges(llvm::MutableArrayRef<MinidumpContext::MemoryRange> ranges) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Pull every page the batch touches with as few syscalls as possible,
+        // each page counts as one hit or miss
+        std::vector<uint64_t> page_addrs;
+        for (const auto& range : ranges) {
+            const uint64_t end = range.address + range.size;
+            for (uint64_t page_addr = range.address & ~(kPageSize - 1); page_addr < end; page_addr += kPageSize) {
+                page_addrs.push_back(page_addr);
+            }
+        }
+        std::sort(page_addrs.begin(), page_addrs.end());
+        page_addrs.erase(std::unique(page_addrs.begin(), page_addrs.end()), page_addrs.end());
+        std::vector<uint64_t> missing;
+        for (const uint64_t page_addr : page_addrs) {
+            if (FindPage(page_addr)) {
+                hits++;
+            } else if (!IsKnownUnmapped(page_addr, kPageSize)) {
+                missing.push_back(page_addr);
+            }
+        }
+        misses += missing.size();
+        FetchPages(std::move(missing));
+
+        size_t complete = 0;
+        for (auto& range : ranges) {
+            range.bytes_read = CopyMemory(range.address, range.buffer, range.size, false);
+            if (range.bytes_read == range.size) {
+                complete++;
+            }
+        }
+        return complete;
+    }
+
+    MinidumpContext::MemoryInfo QueryMemory(uint64_t address) const override {
+        MinidumpContext::MemoryInfo info;
+        auto it = std::upper_bound(mappings.begin(), mappings.end(), address,
+                                   [](uint64_t addr, const LiveMapping& mapping) { return addr < mapping.start; });
+        if (it != mappings.begin() && address < std::prev(it)->end) {
+            info.mapped = true;
+            info.protect = std::prev(it)->protect;
+            info.type = std::prev(it)->type;
+            info.region_base = std::prev(it)->start;
+            info.region_size = std::prev(it)->end - std::prev(it)->start;
+        }
+        info.module = MinidumpContext::FindModule(modules, address);
+        return info;
+    }
+
+    const std::vector<MinidumpContext::ModuleInfo>& GetModules() const override {
+        return modules;
+    }
+
+    uint64_t GetEntryPoint() const override {
+        return instruction_pointer;
+    }
+
+    uint64_t GetThreadTebAddress() const override {
+        return gs_base;
+    }
+
+private:
+    static constexpr uint64_t kPageSize = PREBUILT_MEMORY_CELL_SIZE;
+    static constexpr size_t kMaxIovecs = IOV_MAX;
+
+    struct CachedPage {
+        uint64_t address;
+        std::vector<uint8_t> data;
+    };
+
+    struct LiveMapping {
+        uint64_t start;
+        uint64_t end;
+        uint32_t protect;
+        uint32_t type;
+    };
+
+    static uint32_t ProtectFromPerms(const std::string& perms) {
+        const bool readable = perms.size() > 0 && perms[0] == 'r';
+        const bool writable = perms.size() > 1 && perms[1] == 'w';
+        const bool executable = perms.size() > 2 && perms[2] == 'x';
+        if (executable) {
+            return writable ? MinidumpContext::kPageExecuteReadWrite
+                 : readable ? MinidumpContext::kPageExecuteRead
+                 : MinidumpContext::kPageExecute;
+        }
+        if (writable) {
+            return MinidumpContext::kPageReadWrite;
+        }
+        return readable ? MinidumpContext::kPageReadOnly : MinidumpContext::kPageNoAccess;
+    }
+
+    // Read protections and file-backed modules from /proc/<pid>/maps
+    void LoadMappings() {
+        std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+        std::string line;
+        while (std::getline(maps, line)) {
+            std::istringstream fields(line);
+            std::string range, perms, offset, device, inode, path;
+            fields >> range >> perms >> offset >> device >> inode;
+            std::getline(fields >> std::ws, path);
+
+            const auto dash = range.find('-');
+            if (dash == std::string::npos) {
+                continue;
+            }
+            const bool file_backed = !path.empty() && path[0] == '/';
+            LiveMapping mapping = {
+                std::stoull(range.substr(0, dash), nullptr, 16),
+                std::stoull(range.substr(dash + 1), nullptr, 16),
+                ProtectFromPerms(perms),
+                file_backed ? MinidumpContext::kMemImage : 0,
+            };
+            mappings.push_back(mapping);
+
+            // Consecutive mappings of the same file make up one module
+            if (file_backed) {
+                if (!modules.empty() && modules.back().name == path) {
+                    modules.back().size = mapping.end - modules.back().base;
+                } else {
+                    modules.push_back({mapping.start, mapping.end - mapping.start, path});
+                }
+            }
+        }
+        LOG(INFO) << "Loaded " << std::dec << mappings.size() << " mappings, " << modules.size() << " modules";
+    }
+
+    // Cached or pinned page without fetching or counting it, the lock must be held
+    const std::vector<uint8_t>* FindPage(uint64_t page_addr) const {
+        auto pinned_it = pinned.find(page_addr);
+        if (pinned_it != pinned.end()) {
+            return &pinned_it->second;
+        }
+        auto it = cache.find(page_addr);
+        if (it == cache.end()) {
+            return nullptr;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        return &it->second->data;
+    }
+
+    // Look a page up and fetch it on a miss, the lock must be held. Counted
+    // lookups add one hit or miss, uncounted ones belong to a batch that was
+    // counted already
+    const std::vector<uint8_t>* GetPage(uint64_t page_addr, bool count) const {
+        if (const auto* page = FindPage(page_addr)) {
+            hits += count;
+            return page;
+        }
+        if (IsKnownUnmapped(page_addr, kPageSize)) {
+            return nullptr;
+        }
+        misses += count;
+        FetchPages({page_addr});
+        return FindPage(page_addr);
+    }
+
+    // Move a page out of the LRU so it is not evicted while viewed, the lock
+    // must be held
+    const std::vector<uint8_t>* PinPage(uint64_t page_addr) const {
+        auto pinned_it = pinned.find(page_addr);
+        if (pinned_it != pinned.end()) {
+            hits++;
+            return &pinned_it->second;
+        }
+        if (!GetPage(page_addr, true)) {
+            return nullptr;
+        }
+        auto it = cache.find(page_addr);
+        auto& page = pinned[page_addr] = std::move(it->second->data);
+        lru.erase(it->second);
+        cache.erase(it);
+        return &page;
+    }
+
+    // Copy up to the first unreadable page, the lock must be held
+    size_t CopyMemory(uint64_t address, uint8_t* out, size_t size, bool count) const {
+        size_t copied = 0;
+        while (copied < size) {
+            const uint64_t page_addr = (address + copied) & ~(kPageSize - 1);
+            const auto* page = GetPage(page_addr, count);
+            if (!page) {
+                break;
+            }
+            const uint64_t offset = address + copied - page_addr;
+            const size_t chunk = std::min<uint64_t>(kPageSize - offset, size - copied);
+            std::copy_n(page->data() + offset, chunk, out + copied);
+            copied += chunk;
+        }
+        return copied;
+    }
+
+    void FetchPages(std::vector<uint64_t> page_addrs) const {
+        std::sort(page_addrs.begin(), page_addrs.end());
+        page_addrs.erase(std::unique(page_addrs.begin(), page_addrs.end()), page_addrs.end());
+        page_addrs.erase(std::remove_if(page_addrs.begin(), page_addrs.end(), [this](uint64_t page_addr) {
+            return cache.count(page_addr) || pinned.count(page_addr) || IsKnownUnmapped(page_addr, kPageSize);
+        }), page_addrs.end());
+
+        size_t next = 0;
+        while (next < page_addrs.size()) {
+            const size_t count = std::min(page_addrs.size() - next, kMaxIovecs);
+            std::vector<std::vector<uint8_t>> buffers(count, std::vector<uint8_t>(kPageSize));
+            std::vector<iovec> local(count);
+            std::vector<iovec> remote(count);
+            for (size_t i = 0; i < count; i++) {
+                local[i] = {buffers[i].data(), kPageSize};
+                remote[i] = {reinterpret_cast<void*>(page_addrs[next + i]), kPageSize};
+            }
+
+            // Transfers never split an iovec, so a short read ends at the first unreadable page
+            const ssize_t transferred = process_vm_readv(pid, local.data(), count, remote.data(), count, 0);
+            const size_t pages_read = transferred > 0 ? static_cast<size_t>(transferred) / kPageSize : 0;
+            VLOG(1) << "process_vm_readv: " << std::dec << pages_read << "/" << count << " pages";
+
+            for (size_t i = 0; i < pages_read; i++) {
+                InsertPage(page_addrs[next + i], std::move(buffers[i]));
+            }
+            if (pages_read < count) {
+                VLOG(1) << "Page is not readable: 0x" << std::hex << page_addrs[next + pages_read];
+                AddUnmapped(page_addrs[next + pages_read], kPageSize);
+                next += pages_read + 1;
+            } else {
+                next += count;
+            }
+        }
+    }
+
+    void InsertPage(uint64_t page_addr, std::vector<uint8_t> data) const {
+        lru.push_front({page_addr, std::move(data)});
+        cache[page_addr] = lru.begin();
+        while (lru.size() > cache_capacity) {
+            cache.erase(lru.back().address);
+            lru.pop_back();
+        }
+    }
+
+    pid_t pid;
+    size_t cache_capacity;
+    uint64_t instruction_pointer = 0;
+    uint64_t gs_base = 0;
+    std::vector<LiveMapping> mappings;
+    std::vector<MinidumpContext::ModuleInfo> modules;
+
+    // Guards the cache, the pinned pages and the counters
+    mutable std::mutex mutex;
+    mutable std::list<CachedPage> lru;
+    mutable std::unordered_map<uint64_t, std::list<CachedPage>::iterator> cache;
+    // Pages and multi-page copies handed out as views, kept until
+    // ReleaseViews. Their buffers never move, the maps only own them
+    mutable std::unordered_map<uint64_t, std::vector<uint8_t>> pinned;
+    mutable std::unordered_multimap<uint64_t, std::vector<uint8_t>> spans;
+    mutable size_t hits = 0;
+    mutable size_t misses = 0;
+};
+
+// Create the memory reader for the configured input
+std::unique_ptr<MemoryReader> createMemoryReader(const Options& options) {
+    if (options.getPid() != 0) {
+        LOG(INFO) << "Using live process: " << std::dec << options.getPid();
+        return std::make_unique<LiveProcessMemoryReader>(options.getPid(), options.getLiveCachePages());
+    }
+    if (!options.getSnapshotPath().empty()) {
+        LOG(INFO) << "Using snapshot file: " << options.getSnapshotPath();
+        return std::make_unique<SnapshotMemoryReader>(options.getSnapshotPath());
+    }
+    LOG(INFO) << "Using minidump file: " << options.getMinidumpPath();
+    return std::make_unique<MinidumpMemoryReader>(options.getMinidumpPath());
+}
+
 // Initialize Google logging system
 void initializeLogging(int argc, char* argv[]) {
     google::InitGoogleLogging(argv[0]);
@@ -146,6 +748,30 @@ std::string getFilenamePrefix(std::string purpose, size_t iteration_count) {
     return ss.str();
 }
 
+// Code bytes for the disassembler, straight from the reader's views. Decoding
+// stops at memory known not to be executable, checked once per page. Views
+// end at the page end, so readers that pin pages never copy one across two.
+class MemoryReaderByteSource : public ByteSource {
+public:
+    explicit MemoryReaderByteSource(const MemoryReader& memory_reader) : memory_reader(memory_reader) {}
+
+    llvm::ArrayRef<uint8_t> Fetch(uint64_t address, size_t size) override {
+        const uint64_t page_addr = address & ~(PREBUILT_MEMORY_CELL_SIZE - 1);
+        if (page_addr != checked_page) {
+            if (memory_reader.QueryMemory(address).IsNonExecutable()) {
+                return {};
+            }
+            checked_page = page_addr;
+        }
+        const uint64_t page_left = page_addr + PREBUILT_MEMORY_CELL_SIZE - address;
+        return memory_reader.ReadMemoryView(address, std::min<uint64_t>(size, page_left));
+    }
+
+private:
+    const MemoryReader& memory_reader;
+    uint64_t checked_page = UINT64_MAX;
+};
+
 // Setup initial environment for disassembly and lifting
 void setupEnvironment(std::unique_ptr<llvm::LLVMContext>& llvm_context, 
                      std::vector<uint64_t>& missing_blocks,
@@ -167,71 +793,347 @@ void setupEnvironment(std::unique_ptr<llvm::LLVMContext>& llvm_context,
     entry_point_name = ss.str();
 }
 
+// Queue the import tables, read-only data and code of the loaded modules so
+// the first iteration fetches them in one batch instead of one miss at a time.
+// The module holding the entry point goes first, pages not in the source are
+// left to the regular missing memory path. Returns the number of pages queued
+size_t preloadImageSections(const MemoryReader& memory_reader,
+                            uint64_t entry_point,
+                            size_t max_pages,
+                            std::vector<std::pair<uint64_t, uint8_t>>& added_memory) {
+    const uint64_t page_size = PREBUILT_MEMORY_CELL_SIZE;
+
+    std::vector<const MinidumpContext::ModuleInfo*> modules;
+    for (const auto& module : memory_reader.GetModules()) {
+        if (!module.sections.empty()) {
+            modules.push_back(&module);
+        }
+    }
+    std::stable_partition(modules.begin(), modules.end(), [entry_point](const auto* module) {
+        return entry_point - module->base < module->size;
+    });
+
+    std::unordered_set<uint64_t> queued;
+    for (const auto& item : added_memory) {
+        queued.insert(item.first);
+    }
+    size_t preloaded = 0;
+    const auto queue_range = [&](uint64_t address, uint64_t size) {
+        for (uint64_t page_addr = address & ~(page_size - 1); page_addr < address + size; page_addr += page_size) {
+            if (preloaded >= max_pages) {
+                return;
+            }
+            if (queued.count(page_addr) || !memory_reader.QueryMemory(page_addr).mapped) {
+                continue;
+            }
+            queued.insert(page_addr);
+            added_memory.push_back({page_addr, 0});
+            preloaded++;
+        }
+    };
+
+    for (const auto* module : modules) {
+        const size_t before = preloaded;
+        if (module->iat_size) {
+            queue_range(module->iat_address, module->iat_size);
+        }
+        for (const auto& section : module->sections) {
+            if (!section.IsWritable() && !section.IsExecutable() && (section.characteristics & MinidumpContext::kSectionInitializedData)) {
+                queue_range(section.address, section.size);
+            }
+        }
+        for (const auto& section : module->sections) {
+            if (!section.IsWritable() && section.IsExecutable()) {
+                queue_range(section.address, section.size);
+            }
+        }
+        VLOG(1) << "Preloading " << std::dec << preloaded - before << " pages of " << module->name;
+        if (preloaded >= max_pages) {
+            break;
+        }
+    }
+    LOG(INFO) << "Preloaded " << std::dec << preloaded << " image pages from " << modules.size() << " modules";
+    return preloaded;
+}
+
+// Pages read from the memory source so far. Each one is read and turned into
+// an LLVM constant once, later iterations add the same constants again.
+struct MaterializedMemory {
+    std::vector<BitcodeManipulation::MemoryPage> pages;
+    size_t processed = 0;  // Leading entries of added_memory already read
+};
+
 // Process missing memory and add it to the module
 bool processMissingMemory(std::unique_ptr<llvm::Module>& saved_module, 
-                          std::vector<std::pair<uint64_t, uint8_t>>& added_memory,
+                          const std::vector<std::pair<uint64_t, uint8_t>>& added_memory,
+                          MaterializedMemory& materialized,
                           const MemoryReader& memory_reader) {
-    LOG(INFO) << "Processing " << added_memory.size() << " memory items";
+    const size_t page_size = PREBUILT_MEMORY_CELL_SIZE;
+    LOG(INFO) << "Processing " << added_memory.size() - materialized.processed << " new memory items, "
+              << materialized.pages.size() << " pages from earlier iterations";
+
+    // Fetch the pages added since the last iteration in one sorted batch
+    std::vector<uint64_t> page_addrs;
+    page_addrs.reserve(added_memory.size() - materialized.processed);
+    for (size_t i = materialized.processed; i < added_memory.size(); i++) {
+        if (!memory_reader.IsKnownUnmapped(added_memory[i].first, page_size)) {
+            page_addrs.push_back(added_memory[i].first);
+        }
+    }
+    materialized.processed = added_memory.size();
+    std::sort(page_addrs.begin(), page_addrs.end());
+    page_addrs.erase(std::unique(page_addrs.begin(), page_addrs.end()), page_addrs.end());
+
+    std::vector<uint8_t> pages(page_addrs.size() * page_size);
+    std::vector<MinidumpContext::MemoryRange> ranges;
+    ranges.reserve(page_addrs.size());
+    for (size_t i = 0; i < page_addrs.size(); i++) {
+        ranges.push_back({page_addrs[i], page_size, pages.data() + i * page_size, 0});
+    }
+    memory_reader.ReadRanges(ranges);
     
     // Process each memory item
-    for (const auto& mem_item : added_memory) {
-        const auto page_addr = mem_item.first;
-        const auto page_size = 0x1000; // todo: refactoring artifact
-        LOG(INFO) << "Reading memory at address: 0x" << std::hex << page_addr << " with size: " << page_size;
-        
-        // Read page from the memory source
-        const auto page = memory_reader.ReadMemory(page_addr, page_size);
-        
-        if (page.empty()) {
-            LOG(ERROR) << "Failed to read memory at address: 0x" << std::hex << page_addr;
-            return false;
+    size_t immutable_pages = 0;
+    for (const auto& range : ranges) {
+        // Nothing there, the page becomes a fault stub
+        if (range.bytes_read == 0) {
+            LOG(WARNING) << "Memory at address: 0x" << std::hex << range.address << " is unmapped";
+            memory_reader.AddUnmapped(range.address, page_size);
+            continue;
         }
-        
-        // Add missing memory to module
-        if (!BitcodeManipulation::AddMissingMemory(*saved_module, page_addr, page)) {
-            LOG(ERROR) << "Failed to add missing memory handler for address: 0x" << std::hex << page_addr;
-            return false;
+        // The buffer is zero-initialized, keep whatever part of the page exists
+        if (range.bytes_read != page_size) {
+            LOG(WARNING) << "Partial page at address: 0x" << std::hex << range.address
+                         << ", read " << std::dec << range.bytes_read << " bytes";
         }
+
+        // Read-only image pages can't change, let the optimizer fold reads from them
+        const bool immutable = memory_reader.QueryMemory(range.address).IsImmutable();
+        immutable_pages += immutable;
+        auto* data = llvm::ConstantDataArray::get(saved_module->getContext(), llvm::ArrayRef<uint8_t>(range.buffer, page_size));
+        materialized.pages.push_back({range.address, data, immutable});
+    }
+    LOG(INFO) << "Immutable pages: " << std::dec << immutable_pages << "/" << ranges.size();
+
+    // Add missing memory to module
+    if (!BitcodeManipulation::AddMemoryPages(*saved_module, materialized.pages)) {
+        LOG(ERROR) << "Failed to add " << std::dec << materialized.pages.size() << " memory pages";
+        return false;
     }
-    
     return true;
 }
 
-// First function to handle just the lifting process
-bool liftBasicBlock(std::unique_ptr<llvm::Module>& lifted_module,
-                       const MemoryReader& memory_reader,
-                       llvm::LLVMContext& llvm_context,
-                       uint64_t ip) {
-    BasicBlockLifter lifter(llvm_context);
-    BasicBlockDisassembler disassembler;
+// A function at the address was lifted before, as a block or a callee
+bool isKnownFunction(const std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                     const LiftedBlockMap& block_map,
+                     uint64_t address) {
+    return block_map.Contains(address) ||
+           std::any_of(addr_to_func_map.begin(), addr_to_func_map.end(),
+                       [address](const auto& item) { return item.first == address; });
+}
 
-    LOG(INFO) << "Lifting block at IP: 0x" << std::hex << ip;
+// The lifter defines every direct callee of a trace, as a call to the missing
+// block handler when its code was not part of the trace. Functions another
+// module already defines are turned back into declarations, so the merged
+// module has one definition of each. The functions at `lifted` stay.
+void dropKnownFunctions(llvm::Module& module,
+                        const std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                        llvm::ArrayRef<uint64_t> lifted) {
+    for (const auto& [address, name] : addr_to_func_map) {
+        if (std::find(lifted.begin(), lifted.end(), address) != lifted.end()) {
+            continue;
+        }
+        auto* function = module.getFunction(name);
+        if (function && !function->isDeclaration()) {
+            VLOG(1) << "Dropping definition of " << name << ", it was lifted before";
+            function->deleteBody();
+        }
+    }
+}
 
-    // Read memory for the block
-    auto memory = memory_reader.ReadMemory(ip, 256); // Read enough for a basic block
-    if (memory.empty()) {
-        LOG(ERROR) << "Failed to read memory at IP: 0x" << std::hex << ip;
+// Decode the block at ip for lifting. With a superblock budget direct jumps
+// and calls are followed and the callees the lifter turns into functions of
+// their own are returned in `callees`, callees lifted before are not followed.
+// `entry_count` is the length of the entry block, the part that goes into the
+// block map.
+bool decodeBlock(const MemoryReader& memory_reader,
+                 BasicBlockDisassembler& disassembler,
+                 const LiftedBlockMap& block_map,
+                 const std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                 size_t superblock_max_instructions,
+                 uint64_t ip,
+                 std::vector<DecodedInstruction>& instructions,
+                 size_t& entry_count,
+                 std::vector<uint64_t>& callees) {
+    // Reject decodes into memory that is known not to be executable
+    const auto memory_info = memory_reader.QueryMemory(ip);
+    if (memory_info.IsNonExecutable()) {
+        LOG(ERROR) << "Block at IP: 0x" << std::hex << ip << " is not executable, protection: 0x" << memory_info.protect;
         return false;
     }
 
-    // Disassemble the basic block
-    auto instructions = disassembler.DisassembleBlock(memory.data(), memory.size(), ip);
+    // Bytes are read only as far as the decoder gets. Decoding stops at the
+    // next lifted block, the lifter's missing block call at its address is
+    // later turned into a call to that block so the bytes are lifted once.
+    MemoryReaderByteSource source(memory_reader);
+    const uint64_t stop_addr = block_map.NextStartAfter(ip);
+    if (superblock_max_instructions > 0) {
+        instructions.resize(superblock_max_instructions);
+        const auto is_known = [&](uint64_t address) { return isKnownFunction(addr_to_func_map, block_map, address); };
+        instructions.resize(disassembler.DisassembleSuperblock(source, ip, instructions, callees, is_known, stop_addr));
+    } else {
+        instructions.resize(disassembler.GetMaxInstructions());
+        instructions.resize(disassembler.DisassembleBlock(source, ip, instructions, stop_addr));
+    }
     if (instructions.empty()) {
         LOG(ERROR) << "No instructions decoded at IP: 0x" << std::hex << ip;
         return false;
     }
     VLOG(1) << "Successfully disassembled " << instructions.size() << " instructions";
 
+    // Only the entry block goes into the block map, a later target inside the
+    // followed code is lifted as a block of its own
+    entry_count = 1;
+    while (entry_count < instructions.size() && !instructions[entry_count - 1].IsTerminator() &&
+           instructions[entry_count - 1].GetNextAddress() == instructions[entry_count].address) {
+        entry_count++;
+    }
+    if (entry_count < instructions.size()) {
+        LOG(INFO) << "Superblock at IP: 0x" << std::hex << ip << ", " << std::dec << instructions.size()
+                  << " instructions, " << callees.size() << " callees";
+    }
+    return true;
+}
+
+// First function to handle just the lifting process
+bool liftBasicBlock(std::unique_ptr<llvm::Module>& lifted_module,
+                       const MemoryReader& memory_reader,
+                       LiftingContext& lifting_context,
+                       BasicBlockDisassembler& disassembler,
+                       LiftedBlockMap& block_map,
+                       const std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                       size_t superblock_max_instructions,
+                       uint64_t ip,
+                       std::vector<uint64_t>& callees) {
+    BasicBlockLifter lifter(lifting_context);
+
+    LOG(INFO) << "Lifting block at IP: 0x" << std::hex << ip;
+
+    std::vector<DecodedInstruction> instructions;
+    size_t entry_count = 0;
+    if (!decodeBlock(memory_reader, disassembler, block_map, addr_to_func_map, superblock_max_instructions, ip,
+                     instructions, entry_count, callees)) {
+        return false;
+    }
+    const llvm::ArrayRef<DecodedInstruction> entry_block(instructions.data(), entry_count);
+
+    // The same code at the same address may have been lifted in an earlier run
+    auto* lift_cache = lifting_context.GetDiskCache();
+    std::string cache_key;
+    if (lift_cache) {
+        cache_key = DiskLiftCache::GetKey(lifting_context.GetArchName(), lifting_context.GetSemanticsHash(), ip,
+                                          instructions);
+        lifted_module = lift_cache->Load(cache_key, lifting_context.GetContext());
+        if (lifted_module) {
+            VLOG(1) << "Loaded basic block at IP: 0x" << std::hex << ip << " from the lift cache";
+            block_map.Add(ip, entry_block);
+            dropKnownFunctions(*lifted_module, addr_to_func_map, ip);
+            return true;
+        }
+    }
+
     // Lift the block
     if (!lifter.LiftBlock(instructions, ip)) {
         LOG(ERROR) << "Failed to lift basic block at IP: 0x" << std::hex << ip;
         return false;
     }
     VLOG(1) << "Successfully lifted basic block at IP: 0x" << std::hex << ip;
+    block_map.Add(ip, entry_block);
 
     // Get the module from lifter
     lifted_module = lifter.TakeModule();
+    // Stored whole, another session may not know the callees
+    if (lift_cache) {
+        lift_cache->Store(cache_key, *lifted_module);
+    }
+    dropKnownFunctions(*lifted_module, addr_to_func_map, ip);
+
+    return true;
+}
+
+// Lift the function body reachable from ip in one trace. The lifter reads the
+// code bytes itself and follows every direct branch, so nothing is decoded up
+// front and the block map is left alone: a later target inside the trace
+// becomes a trace of its own rather than a split.
+bool liftFunctionTrace(std::unique_ptr<llvm::Module>& lifted_module,
+                       const MemoryReader& memory_reader,
+                       LiftingContext& lifting_context,
+                       const std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                       uint64_t ip) {
+    LOG(INFO) << "Lifting function trace at IP: 0x" << std::hex << ip;
+
+    const auto memory_info = memory_reader.QueryMemory(ip);
+    if (memory_info.IsNonExecutable()) {
+        LOG(ERROR) << "Block at IP: 0x" << std::hex << ip << " is not executable, protection: 0x" << memory_info.protect;
+        return false;
+    }
+
+    BasicBlockLifter lifter(lifting_context);
+    MemoryReaderByteSource source(memory_reader);
+    if (!lifter.LiftTrace(source, ip)) {
+        LOG(ERROR) << "Failed to lift function trace at IP: 0x" << std::hex << ip;
+        return false;
+    }
+    lifted_module = lifter.TakeModule();
+    dropKnownFunctions(*lifted_module, addr_to_func_map, ip);
+    return true;
+}
 
+// Callees lifted inside a superblock are functions of their own, register them
+// so the missing block handler dispatches to them instead of lifting them again
+void addCalleeFunctions(std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                        const std::vector<uint64_t>& callees) {
+    for (const auto callee : callees) {
+        const bool known = std::any_of(addr_to_func_map.begin(), addr_to_func_map.end(),
+            [callee](const auto& item) { return item.first == callee; });
+        if (known) {
+            continue;
+        }
+        std::stringstream callee_ss;
+        callee_ss << "sub_" << std::hex << callee;
+        addr_to_func_map.emplace_back(callee, callee_ss.str());
+    }
+}
+
+// Lift the two halves of a block split at a new target. The head is lifted
+// again, now falling through to the target, and the tail reuses the decoded
+// instructions. The old head definition is dropped from its module so the
+// bytes past the target exist only once in the merged module.
+bool liftSplitBlock(std::unique_ptr<llvm::Module>& lifted_module,
+                    std::vector<std::unique_ptr<llvm::Module>>& lifted_modules,
+                    LiftingContext& lifting_context,
+                    const std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                    const LiftedBlockMap::Block& head,
+                    const LiftedBlockMap::Block& tail) {
+    LOG(INFO) << "Splitting block at 0x" << std::hex << head.address << " at IP: 0x" << tail.address;
+
+    BasicBlockLifter lifter(lifting_context);
+    if (!lifter.LiftBlock(head.instructions, head.address) || !lifter.LiftBlock(tail.instructions, tail.address)) {
+        LOG(ERROR) << "Failed to lift split block at 0x" << std::hex << head.address;
+        return false;
+    }
+
+    std::stringstream head_ss;
+    head_ss << "sub_" << std::hex << head.address;
+    for (auto& module : lifted_modules) {
+        auto* function = module->getFunction(head_ss.str());
+        if (function && !function->isDeclaration()) {
+            function->deleteBody();
+        }
+    }
+
+    lifted_module = lifter.TakeModule();
+    dropKnownFunctions(*lifted_module, addr_to_func_map, {head.address, tail.address});
     return true;
 }
 
@@ -254,9 +1156,9 @@ bool prepareBlockForRun(std::unique_ptr<llvm::Module>& output_module,
     BitcodeManipulation::RemoveSuffixFromFunctions(*output_module);
 
     // Add mapping for this block
-    // check if the block_func_name already exists in addr_to_func_map
+    // check if the block already has a function or a fault stub in addr_to_func_map
     if (std::find_if(addr_to_func_map.begin(), addr_to_func_map.end(), 
-                     [&](const auto& pair) { return pair.second == block_func_name; }) != addr_to_func_map.end()) {
+                     [&](const auto& pair) { return pair.first == ip; }) != addr_to_func_map.end()) {
         LOG(INFO) << "Block function name already exists: " << block_func_name;
     } else {
         addr_to_func_map.emplace_back(ip, block_func_name);
@@ -273,7 +1175,10 @@ bool prepareBlockForRun(std::unique_ptr<llvm::Module>& output_module,
             LOG(ERROR) << "Failed to load Utils.ll module";
             return false;
         }
-        BitcodeManipulation::MergeModules(*output_module, *utils_module);
+        if (!BitcodeManipulation::MergeModules(*output_module, *utils_module)) {
+            LOG(ERROR) << "Failed to merge Utils.ll module";
+            return false;
+        }
         BitcodeManipulation::ReplaceFunction(*output_module, "main_next", entry_point_name);
         BitcodeManipulation::SetGlobalVariableUint64(*output_module, "StartPC", entry_point);
         BitcodeManipulation::SetGlobalVariableUint64(*output_module, "GSBase", memory_reader.GetThreadTebAddress());
@@ -282,14 +1187,429 @@ bool prepareBlockForRun(std::unique_ptr<llvm::Module>& output_module,
     return true;
 }
 
-// Run JIT compilation and execution
+// Code bytes for discovery, nothing is decoded from memory known not to be executable
+Discovery::CodeReader makeCodeReader(const MemoryReader& memory_reader) {
+    return [&memory_reader](uint64_t address, size_t size) -> llvm::ArrayRef<uint8_t> {
+        if (memory_reader.QueryMemory(address).IsNonExecutable()) {
+            return {};
+        }
+        return memory_reader.ReadMemoryView(address, size);
+    };
+}
+
+// Linear sweep over the executable sections of every module, the decoded
+// blocks land in decode_cache where discovery and the disassembler find them.
+// The sweep is returned for its block starts, null if nothing was swept
+std::unique_ptr<Discovery::LinearSweep> sweepExecutableSections(const MemoryReader& memory_reader,
+                                                                size_t threads,
+                                                                DecodeCache& decode_cache) {
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<MinidumpContext::MemoryRange> ranges;
+    for (const auto& module : memory_reader.GetModules()) {
+        for (const auto& section : module.sections) {
+            if (section.IsExecutable()) {
+                buffers.emplace_back(section.size);
+                ranges.push_back({section.address, section.size, buffers.back().data(), 0});
+            }
+        }
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) { return a.address < b.address; });
+    memory_reader.ReadRanges(ranges);
+
+    // Sections missing from the dump are swept up to the first unreadable byte
+    std::vector<Discovery::CodeRegion> regions;
+    for (const auto& range : ranges) {
+        if (range.bytes_read > 0) {
+            regions.push_back({range.address, llvm::ArrayRef<uint8_t>(range.buffer, range.bytes_read)});
+        }
+    }
+    if (regions.empty()) {
+        LOG(WARNING) << "No executable sections to sweep";
+        return nullptr;
+    }
+
+    auto sweep = std::make_unique<Discovery::LinearSweep>(decode_cache, threads);
+    sweep->Run(regions);
+    return sweep;
+}
+
+// Jump table entries for discovery, read whole or not at all
+Discovery::DataReader makeDataReader(const MemoryReader& memory_reader) {
+    return [&memory_reader](uint64_t address, uint8_t* buffer, size_t size) {
+        const auto data = memory_reader.ReadMemory(address, size);
+        if (data.size() != size) {
+            return false;
+        }
+        std::copy(data.begin(), data.end(), buffer);
+        return true;
+    };
+}
+
+// When the block at ip dispatches through a jump table, lift every case at
+// once instead of finding them one run at a time through the missing block
+// handler. The bounds check is looked for in the block falling through to ip.
+size_t liftJumpTableTargets(const MemoryReader& memory_reader,
+                            LiftingContext& lifting_context,
+                            BasicBlockDisassembler& disassembler,
+                            LiftedBlockMap& block_map,
+                            size_t superblock_max_instructions,
+                            std::vector<std::unique_ptr<llvm::Module>>& lifted_modules,
+                            std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                            uint64_t ip) {
+    const auto* block = block_map.GetBlock(ip);
+    if (!block || block->instructions.empty() || !Discovery::IsIndirectJump(block->instructions.back())) {
+        return 0;
+    }
+    std::vector<DecodedInstruction> window;
+    const auto* predecessor = ip > 0 ? block_map.FindContaining(ip - 1) : nullptr;
+    if (predecessor && predecessor->GetEnd() == ip && predecessor->instructions.back().IsCondBranch()) {
+        window = predecessor->instructions;
+    }
+    window.insert(window.end(), block->instructions.begin(), block->instructions.end());
+
+    Discovery::JumpTable table;
+    // Targets with unknown protection are taken as code, as for decoding
+    const auto is_code = [&memory_reader](uint64_t target) { return !memory_reader.QueryMemory(target).IsNonExecutable(); };
+    if (!Discovery::RecognizeJumpTable(XEDDisassembler::Get(), window, table) ||
+        !Discovery::ReadJumpTable(table, makeDataReader(memory_reader), is_code)) {
+        return 0;
+    }
+
+    size_t lifted = 0;
+    for (const auto target : table.targets) {
+        const bool known = std::any_of(addr_to_func_map.begin(), addr_to_func_map.end(),
+            [target](const auto& item) { return item.first == target; });
+        if (known || block_map.Contains(target)) {
+            continue;
+        }
+        std::unique_ptr<llvm::Module> lifted_module;
+        std::vector<uint64_t> callees;
+        if (!liftBasicBlock(lifted_module, memory_reader, lifting_context, disassembler, block_map, addr_to_func_map,
+                            superblock_max_instructions, target, callees)) {
+            continue;
+        }
+        std::stringstream block_ss;
+        block_ss << "sub_" << std::hex << target;
+        addr_to_func_map.emplace_back(target, block_ss.str());
+        addCalleeFunctions(addr_to_func_map, callees);
+        lifted_modules.push_back(std::move(lifted_module));
+        lifted++;
+    }
+    LOG(INFO) << "Jump table at 0x" << std::hex << table.table_address << ": lifted " << std::dec << lifted
+              << " of " << table.targets.size() << " targets";
+    return lifted;
+}
+
+// Lift the pending missing blocks together on the worker pool. Decoding, the
+// lift cache and the block map stay on this thread, only remill runs on the
+// workers. A block splitting one lifted earlier is lifted here. Addresses
+// inside another block of the batch, and blocks that failed, are left in
+// `addresses` for the serial path, which splits or reports them. Every module
+// is dumped like the serial path's, named after its block.
+size_t liftPendingBlocks(const MemoryReader& memory_reader,
+                         LiftingContext& lifting_context,
+                         LiftWorkerPool& lift_pool,
+                         BasicBlockDisassembler& disassembler,
+                         LiftedBlockMap& block_map,
+                         size_t superblock_max_instructions,
+                         std::vector<std::unique_ptr<llvm::Module>>& lifted_modules,
+                         std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                         std::vector<uint64_t>& addresses,
+                         size_t iteration_count) {
+    // Every block the batch adds to the block map, split, cached or lifted
+    std::vector<uint64_t> added;
+    const auto add_block = [&](uint64_t address, std::unique_ptr<llvm::Module> lifted_module) {
+        std::stringstream block_ss;
+        block_ss << "sub_" << std::hex << address;
+        addr_to_func_map.emplace_back(address, block_ss.str());
+        BitcodeManipulation::DumpModule(*lifted_module, getFilenamePrefix("lifted_" + block_ss.str(), iteration_count));
+        lifted_modules.push_back(std::move(lifted_module));
+        added.push_back(address);
+    };
+
+    struct Pending {
+        size_t entry_count = 0;
+        std::vector<uint64_t> callees;
+        std::string cache_key;
+    };
+    std::vector<LiftWorkerPool::Request> requests;
+    std::vector<Pending> pending;
+    std::vector<uint64_t> remaining;
+    std::unordered_set<uint64_t> seen;
+    LiftedBlockMap batch_map;
+    auto* lift_cache = lifting_context.GetDiskCache();
+    size_t lifted = 0;
+    size_t cached = 0;
+
+    for (const auto address : addresses) {
+        const bool known = std::any_of(addr_to_func_map.begin(), addr_to_func_map.end(),
+            [address](const auto& item) { return item.first == address; });
+        if (!seen.insert(address).second || known) {
+            continue;
+        }
+        if (batch_map.FindContaining(address)) {
+            remaining.push_back(address);
+            continue;
+        }
+
+        std::unique_ptr<llvm::Module> lifted_module;
+        LiftedBlockMap::Block head, tail;
+        if (block_map.Split(address, head, tail)) {
+            if (!liftSplitBlock(lifted_module, lifted_modules, lifting_context, addr_to_func_map, head, tail)) {
+                remaining.push_back(address);
+                continue;
+            }
+            add_block(address, std::move(lifted_module));
+            lifted++;
+            continue;
+        }
+
+        LiftWorkerPool::Request request{address, {}};
+        Pending block;
+        if (!decodeBlock(memory_reader, disassembler, block_map, addr_to_func_map, superblock_max_instructions, address,
+                         request.instructions, block.entry_count, block.callees)) {
+            remaining.push_back(address);
+            continue;
+        }
+        const llvm::ArrayRef<DecodedInstruction> entry_block(request.instructions.data(), block.entry_count);
+        batch_map.Add(address, entry_block);
+
+        if (lift_cache) {
+            block.cache_key = DiskLiftCache::GetKey(lifting_context.GetArchName(), lifting_context.GetSemanticsHash(),
+                                                    address, request.instructions);
+            lifted_module = lift_cache->Load(block.cache_key, lifting_context.GetContext());
+            if (lifted_module) {
+                block_map.Add(address, entry_block);
+                dropKnownFunctions(*lifted_module, addr_to_func_map, address);
+                add_block(address, std::move(lifted_module));
+                addCalleeFunctions(addr_to_func_map, block.callees);
+                cached++;
+                continue;
+            }
+        }
+        requests.push_back(std::move(request));
+        pending.push_back(std::move(block));
+    }
+
+    // Parsed in request order, so the merged module does not depend on which
+    // worker finished first
+    const auto results = lift_pool.Lift(requests);
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto address = requests[i].address;
+        // Lifted as the callee of an earlier superblock of the batch
+        const bool known = std::any_of(addr_to_func_map.begin(), addr_to_func_map.end(),
+            [address](const auto& item) { return item.first == address; });
+        if (known) {
+            continue;
+        }
+        auto lifted_module = LiftWorkerPool::ParseResult(results[i], lifting_context.GetContext());
+        if (!lifted_module) {
+            remaining.push_back(address);
+            continue;
+        }
+        if (lift_cache) {
+            lift_cache->Store(pending[i].cache_key, *lifted_module);
+        }
+        block_map.Add(address, llvm::ArrayRef<DecodedInstruction>(requests[i].instructions.data(), pending[i].entry_count));
+        // Superblocks decoded earlier in the batch may have defined its callees
+        dropKnownFunctions(*lifted_module, addr_to_func_map, address);
+        add_block(address, std::move(lifted_module));
+        addCalleeFunctions(addr_to_func_map, pending[i].callees);
+        lifted++;
+    }
+
+    // Jump tables are recognized once the dispatching blocks are in the block map
+    for (const auto address : added) {
+        lifted += liftJumpTableTargets(memory_reader, lifting_context, disassembler, block_map,
+                                       superblock_max_instructions, lifted_modules, addr_to_func_map, address);
+    }
+
+    LOG(INFO) << "Lifted " << std::dec << lifted << " pending blocks on " << lift_pool.GetThreadCount()
+              << " threads, " << cached << " from the lift cache, " << remaining.size() << " left";
+    addresses = std::move(remaining);
+    return lifted + cached;
+}
+
+// Lift every block reachable from the entry point through direct control flow
+// before the first run, so the JIT only reports blocks behind indirect branches.
+// The blocks go into one module and are registered in addr_to_func_map.
+bool liftStaticBlocks(const MemoryReader& memory_reader,
+                      LiftingContext& lifting_context,
+                      DecodeCache& decode_cache,
+                      uint64_t entry_point,
+                      uint64_t stop_addr,
+                      size_t max_blocks,
+                      LiftedBlockMap& block_map,
+                      std::vector<std::unique_ptr<llvm::Module>>& lifted_modules,
+                      std::vector<std::pair<uint64_t, std::string>>& addr_to_func_map,
+                      const Discovery::BlockStartBitmap* block_starts) {
+    Discovery::StaticDiscovery discovery(decode_cache, makeCodeReader(memory_reader), max_blocks);
+    discovery.AddStopAddress(stop_addr);
+    discovery.SetDataReader(makeDataReader(memory_reader));
+    const auto blocks = discovery.Run(entry_point);
+    if (blocks.empty()) {
+        return false;
+    }
+
+    // A block running into another block's start is cut there, the
+    // overlapping bytes are only lifted as part of the later block
+    std::vector<uint64_t> addresses;
+    for (const auto& block : blocks) {
+        block_map.Add(block.address, block.instructions);
+        addresses.push_back(block.address);
+    }
+    LiftedBlockMap::Block head, tail;
+    for (const auto& block : blocks) {
+        block_map.Split(block.address, head, tail);
+    }
+
+    // Blocks are cut at the starts the sweep found as well, a branch there
+    // later finds a lifted block instead of splitting one
+    size_t sweep_cuts = 0;
+    if (block_starts) {
+        for (const auto& block : blocks) {
+            for (size_t i = 1; i < block.instructions.size(); i++) {
+                const auto address = block.instructions[i].address;
+                if (block_starts->Test(address) && !block_map.Contains(address) &&
+                    block_map.Split(address, head, tail)) {
+                    addresses.push_back(address);
+                    sweep_cuts++;
+                }
+            }
+        }
+    }
+
+    BasicBlockLifter lifter(lifting_context);
+    size_t lifted = 0;
+    for (const auto address : addresses) {
+        // A block that fails here is reported again by the JIT if it is reached
+        if (!lifter.LiftBlock(block_map.GetBlock(address)->instructions, address)) {
+            LOG(WARNING) << "Failed to lift statically discovered block at 0x" << std::hex << address;
+            continue;
+        }
+        std::stringstream block_ss;
+        block_ss << "sub_" << std::hex << address;
+        addr_to_func_map.emplace_back(address, block_ss.str());
+        lifted++;
+    }
+
+    auto lifted_module = lifter.TakeModule();
+    if (!lifted_module || lifted == 0) {
+        return false;
+    }
+    BitcodeManipulation::DumpModule(*lifted_module, "lifted-static.ll");
+    lifted_modules.push_back(std::move(lifted_module));
+    LOG(INFO) << "Lifted " << std::dec << lifted << " of " << addresses.size() << " statically discovered blocks, "
+              << sweep_cuts << " cut at sweep block starts";
+    return true;
+}
+
+// Lift the code reachable from every captured thread. Each thread gets its own
+// discovery session on the pool, decoding runs in parallel while lifting goes
+// through one lifter because the LLVM context can't be shared between threads
+bool liftAllThreads(const MemoryReader& memory_reader,
+                    LiftingContext& lifting_context,
+                    const Options& options) {
+    const auto contexts = memory_reader.GetThreadContexts();
+    LOG(INFO) << "Lifting from " << std::dec << contexts.size() << " threads";
+
+    Discovery::SharedCaches caches;
+    BasicBlockLifter lifter(lifting_context);
+    std::mutex lifter_mutex;
+    if (options.getSweepCode()) {
+        sweepExecutableSections(memory_reader, options.getDiscoveryThreads(), caches.decoded);
+    }
+
+    const auto read_code = makeCodeReader(memory_reader);
+    const auto lift_block = [&lifter, &lifter_mutex](llvm::ArrayRef<DecodedInstruction> instructions, uint64_t address) {
+        std::lock_guard<std::mutex> lock(lifter_mutex);
+        return lifter.LiftBlock(instructions, address);
+    };
+
+    std::vector<std::unique_ptr<Discovery::DiscoverySession>> sessions;
+    {
+        Discovery::ThreadPool pool(options.getDiscoveryThreads());
+        VLOG(1) << "Discovery pool with " << std::dec << pool.GetThreadCount() << " threads";
+        for (const auto& context : contexts) {
+            sessions.push_back(std::make_unique<Discovery::DiscoverySession>(
+                context.id, context.instruction_pointer, caches, read_code, lift_block,
+                options.getMaxBlocksPerThread()));
+            pool.Submit([session = sessions.back().get()] { session->Run(); });
+        }
+        pool.Wait();
+    }
+    memory_reader.ReleaseViews();
+
+    size_t shared = 0;
+    for (const auto& session : sessions) {
+        shared += session->GetBlocksShared();
+    }
+    LOG(INFO) << "Lifted " << std::dec << caches.lifted.GetLiftedCount() << " unique blocks, "
+              << shared << " reached by more than one thread";
+    LOG(INFO) << "Decode cache: " << caches.decoded.GetSize() << " instructions, "
+              << caches.decoded.GetHits() << " hits, " << caches.decoded.GetMisses() << " misses";
+
+    auto lifted_module = lifter.TakeModule();
+    if (!lifted_module) {
+        LOG(ERROR) << "No blocks were lifted";
+        return false;
+    }
+    BitcodeManipulation::DumpModule(*lifted_module, "lifted-threads.ll");
+    return true;
+}
+
+// Add the saved memory lookup and optimize the merged module for a run. With
+// track_access the lookup records the pages it hands out; GlobalMemoryCellsAccessed
+// is then kept external so the JIT can read it back
+bool optimizeMergedModule(llvm::Module& module,
+                          llvm::ArrayRef<std::pair<uint64_t, uint64_t>> fault_ranges,
+                          bool track_access,
+                          bool strip_unreachable,
+                          size_t iteration_count,
+                          bool dump) {
+    if (BitcodeManipulation::CreateGetSavedMemoryPtr(module, track_access, fault_ranges) == nullptr) {
+        LOG(ERROR) << "Failed to create get saved memory ptr";
+        return false;
+    }
+
+    auto exclusion = std::vector<std::string>{"main"};
+    if (track_access) {
+        exclusion.push_back("GlobalMemoryCellsAccessed");
+    }
+    BitcodeManipulation::ReplaceFunction(module, "__remill_write_memory_64", "__remill_write_memory_64_opt");
+    // Most of the semantics and Utils.ll are never called, don't inline and optimize them
+    if (strip_unreachable) {
+        BitcodeManipulation::StripUnreachable(module, exclusion);
+    }
+    BitcodeManipulation::RemoveOptNoneAttribute(module, exclusion);
+    BitcodeManipulation::MakeSymbolsInternal(module, exclusion);
+    BitcodeManipulation::MakeFunctionsInline(module, exclusion);
+    if (dump) {
+        BitcodeManipulation::DumpModule(module, getFilenamePrefix("opt_pre", iteration_count));
+    }
+    BitcodeManipulation::OptimizeModule(module, 3); // Calling optimize module twice is intentional
+    if (dump) {
+        BitcodeManipulation::DumpModule(module, getFilenamePrefix("opt", iteration_count));
+    }
+    BitcodeManipulation::OptimizeModule(module, 3); // Calling optimize module twice is intentional
+    if (dump) {
+        BitcodeManipulation::DumpModule(module, getFilenamePrefix("opt2", iteration_count));
+    }
+    return true;
+}
+
+// Run JIT compilation and execution. The tracked module, when there is one,
+// is run in place of the saved module and reports the pages it accessed
 bool executeJITCode(std::unique_ptr<llvm::Module>& saved_module,
+                   const llvm::Module* tracked_module,
                    uint64_t ip,
                    uint64_t entry_point,
                    const std::string& filename_prefix,
                    std::vector<std::pair<uint64_t, uint8_t>>& missing_memory,
                    std::vector<std::pair<uint64_t, uint8_t>>& added_memory,
-                   std::vector<uint64_t>& missing_blocks) {
+                   std::vector<uint64_t>& missing_blocks,
+                   const MemoryReader& memory_reader,
+                   Runtime::MemoryReadAhead& read_ahead) {
 
     // Dump module to file for debugging
     std::stringstream ss;
@@ -298,7 +1618,8 @@ bool executeJITCode(std::unique_ptr<llvm::Module>& saved_module,
     BitcodeManipulation::DumpModule(*saved_module, filename);
 
     // Initialize JIT engine with the updated module
-    auto jit_module = llvm::CloneModule(*saved_module);
+    const llvm::Module& run_module = tracked_module ? *tracked_module : *saved_module;
+    auto jit_module = llvm::CloneModule(run_module);
     JITEngine jit;
     if (!jit.Initialize(std::move(jit_module))) {
         LOG(ERROR) << "Failed to initialize JIT engine";
@@ -315,6 +1636,21 @@ bool executeJITCode(std::unique_ptr<llvm::Module>& saved_module,
     VLOG(1) << "Successfully executed lifted code at IP: 0x" << std::hex << entry_point;
     LOG(INFO) << "Result: " << result;
 
+    // Settle the previous prefetches against the pages this run actually read
+    const auto accessed_global = run_module.getGlobalVariable("GlobalMemoryCellsAccessed");
+    const auto accessed_addr = jit.GetGlobalAddress("GlobalMemoryCellsAccessed");
+    if (accessed_global && accessed_addr) {
+        const auto count = llvm::cast<llvm::ArrayType>(accessed_global->getValueType())->getNumElements();
+        const auto accessed = reinterpret_cast<const uint64_t*>(accessed_addr);
+        std::unordered_set<uint64_t> accessed_pages;
+        for (size_t i = 0; i < count; i++) {
+            if (accessed[i] != 0) {
+                accessed_pages.insert(accessed[i]);
+            }
+        }
+        read_ahead.OnExecuted(accessed_pages);
+    }
+
     // Process any new missing memory
     bool missing_memory_found = false;
     const auto &new_missing_memory = Runtime::MissingMemoryTracker::GetMissingMemory();
@@ -325,7 +1661,22 @@ bool executeJITCode(std::unique_ptr<llvm::Module>& saved_module,
     }
     
     VLOG(1) << "Taking only first missing memory, if it's not already in missing_memory...";
+    bool page_added = false;
     for (const auto &mem : new_missing_memory) {
+        // Unmapped pages don't need an iteration of their own, they all get
+        // fault stubs together with the next mapped page
+        if (memory_reader.IsKnownUnmapped(mem.first, PREBUILT_MEMORY_CELL_SIZE)) {
+            continue;
+        }
+        if (!memory_reader.QueryMemory(mem.first).mapped) {
+            LOG(INFO) << "Missing memory is unmapped, adding fault stub: " << std::hex << mem.first;
+            memory_reader.AddUnmapped(mem.first, PREBUILT_MEMORY_CELL_SIZE);
+            missing_memory.push_back(mem);
+            continue;
+        }
+        if (page_added) {
+            continue;
+        }
         bool found = false;
         for (const auto& addr : added_memory) {
             if (addr.first == mem.first) {
@@ -337,11 +1688,44 @@ bool executeJITCode(std::unique_ptr<llvm::Module>& saved_module,
             LOG(INFO) << "Adding missing memory: " << std::hex << mem.first << ", size: " << mem.second << " bytes";
             missing_memory.push_back(mem);
             added_memory.push_back(mem);
-            break; // todo: push only first missing memory
+
+            // Prefetch neighbours from the same region, they are fetched in
+            // the same batch as the missing page
+            const auto region = memory_reader.QueryMemory(mem.first);
+            for (const auto page_addr : read_ahead.OnMiss(mem.first)) {
+                const auto info = memory_reader.QueryMemory(page_addr);
+                if (!info.ContainsRange(page_addr, PREBUILT_MEMORY_CELL_SIZE) || info.region_base != region.region_base) {
+                    break;
+                }
+                const bool already_added = std::any_of(added_memory.begin(), added_memory.end(),
+                    [page_addr](const auto& item) { return item.first == page_addr; });
+                if (already_added) {
+                    continue;
+                }
+                VLOG(1) << "Prefetching memory: " << std::hex << page_addr;
+                added_memory.push_back({page_addr, 0});
+                // Reads from constant pages are not tracked, they can't count as used or wasted
+                if (!info.IsImmutable()) {
+                    read_ahead.AddPrefetched(page_addr);
+                }
+            }
+            page_added = true; // todo: push only first missing memory
         }
     }
     Runtime::MissingMemoryTracker::ClearMissingMemory();
 
+    const auto fault_count = Runtime::MemoryFaultTracker::GetFaultCount();
+    if (fault_count > 0) {
+        VLOG(1) << "Reads from unmapped memory: " << std::dec << fault_count << " in "
+                << Runtime::MemoryFaultTracker::GetFaultPages().size() << " pages";
+    }
+    Runtime::MemoryFaultTracker::ClearFaults();
+
+    for (const auto pc : Runtime::BlockFaultTracker::GetFaultBlocks()) {
+        LOG(INFO) << "Branch to non-executable memory: 0x" << std::hex << pc;
+    }
+    Runtime::BlockFaultTracker::ClearFaults();
+
     // Process any new missing blocks
     const auto &new_missing_blocks = Runtime::MissingBlockTracker::GetMissingBlocks();
     if (!missing_memory_found && new_missing_blocks.size() > 0) {
@@ -365,7 +1749,7 @@ int main(int argc, char* argv[]) {
 
     try {
         // Set up gflags
-        std::string usage = std::string("Usage: ") + argv[0] + " --minidump=<path_to_minidump> --stop_addr=<hex_address> [options]";
+        std::string usage = std::string("Usage: ") + argv[0] + " (--minidump=<path_to_minidump> | --snapshot=<path_to_snapshot> | --pid=<pid>) --stop_addr=<hex_address> [options]";
         gflags::SetUsageMessage(usage);
         gflags::SetVersionString("1.0.0");
         
@@ -381,12 +1765,39 @@ int main(int argc, char* argv[]) {
         // Parse command line options
         Recycle::Options options(argc, argv);
         
-        // Create memory reader from minidump
-        Recycle::MinidumpMemoryReader memory_reader(options.getMinidumpPath());
+        // Convert the minidump into a snapshot file if requested
+        if (!options.getWriteSnapshotPath().empty()) {
+            Recycle::MinidumpMemoryReader minidump_reader(options.getMinidumpPath());
+            const auto& minidump = minidump_reader.GetMinidump();
+            if (!Snapshot::WriteSnapshot(options.getWriteSnapshotPath(), minidump.GetRegionIndex(), minidump.GetModules(),
+                                         minidump.GetInstructionPointer(), minidump.GetThreadTebAddress())) {
+                return 1;
+            }
+            return 0;
+        }
+
+        // Create memory reader from minidump or snapshot
+        const auto memory_reader_ptr = Recycle::createMemoryReader(options);
+        const auto& memory_reader = *memory_reader_ptr;
         uint64_t entry_point = memory_reader.GetEntryPoint();
         
         // Setup environment - create a single LLVM context that will be shared throughout execution
         auto llvm_context = std::make_unique<llvm::LLVMContext>();
+        // The remill semantics are loaded once and shared by every lifted block
+        LiftingContext lifting_context(*llvm_context);
+        std::unique_ptr<DiskLiftCache> lift_cache;
+        if (!options.getLiftCacheDir().empty()) {
+            lift_cache = std::make_unique<DiskLiftCache>(options.getLiftCacheDir(), options.getLiftCacheMaxBytes());
+            if (lift_cache->Open()) {
+                lifting_context.SetDiskCache(lift_cache.get());
+            } else {
+                LOG(WARNING) << "Lifting without the lift cache";
+            }
+        }
+
+        if (options.getAllThreads()) {
+            return Recycle::liftAllThreads(memory_reader, lifting_context, options) ? 0 : 1;
+        }
         
         std::vector<uint64_t> missing_blocks;
         std::string entry_point_name;
@@ -396,10 +1807,37 @@ int main(int argc, char* argv[]) {
         std::vector<std::pair<uint64_t, std::string>> addr_to_func_map;
         std::vector<std::pair<uint64_t, uint8_t>> missing_memory;
         std::vector<std::pair<uint64_t, uint8_t>> added_memory;
+        Recycle::MaterializedMemory materialized_memory;
         std::vector<std::unique_ptr<llvm::Module>> lifted_modules;
         uint64_t ip = 0;
         size_t iteration_count = 0;
+        Runtime::MemoryReadAhead read_ahead(options.getReadAheadMaxPages());
 
+        // Lifting several pending blocks at once pays off once there are threads to spare
+        std::unique_ptr<LiftWorkerPool> lift_pool;
+        if (options.getLiftThreads() != 1) {
+            lift_pool = std::make_unique<LiftWorkerPool>(options.getLiftThreads());
+        }
+
+        // Revisited and overlapping blocks are walked through the cache
+        DecodeCache decode_cache;
+        BasicBlockDisassembler disassembler(32, &decode_cache);
+        LiftedBlockMap block_map;
+        // Block starts from the sweep, kept for the static discovery below
+        std::unique_ptr<Discovery::LinearSweep> sweep;
+        if (options.getPreloadMaxPages() > 0) {
+            Recycle::preloadImageSections(memory_reader, entry_point, options.getPreloadMaxPages(), added_memory);
+        }
+        if (options.getSweepCode()) {
+            sweep = Recycle::sweepExecutableSections(memory_reader, options.getDiscoveryThreads(), decode_cache);
+        }
+        if (options.getStaticMaxBlocks() > 0 &&
+            !Recycle::liftStaticBlocks(memory_reader, lifting_context, decode_cache, entry_point, options.getStopAddr(),
+                                       options.getStaticMaxBlocks(), block_map, lifted_modules, addr_to_func_map,
+                                       sweep ? &sweep->GetBlockStarts() : nullptr)) {
+            LOG(WARNING) << "Static discovery lifted nothing, continuing with dynamic discovery only";
+        }
+        memory_reader.ReleaseViews();
 
         // Main processing loop
         while ((missing_blocks.size() > 0 || missing_memory.size() > 0) && 
@@ -410,12 +1848,50 @@ int main(int argc, char* argv[]) {
                 // Process a missing block
                 ip = missing_blocks.back();
                 missing_blocks.pop_back();
-                
+            }
+            // The blocks still pending are lifted together with ip, leaving only
+            // those the batch could not handle for later iterations
+            if (lift_pool && !missing_blocks.empty()) {
+                missing_blocks.push_back(ip);
+                Recycle::liftPendingBlocks(memory_reader, lifting_context, *lift_pool, disassembler, block_map,
+                                           options.getSuperblockMaxInstructions(), lifted_modules,
+                                           addr_to_func_map, missing_blocks, iteration_count);
+                missing_blocks.erase(std::remove(missing_blocks.begin(), missing_blocks.end(), ip), missing_blocks.end());
+            }
+            // Blocks found by static discovery are already in the lifted modules
+            bool already_lifted = std::any_of(addr_to_func_map.begin(), addr_to_func_map.end(),
+                [ip](const auto& item) { return item.first == ip; });
+            // A branch into memory known not to be executable faults like a
+            // read from an unmapped page, the handler dispatches it to a stub
+            if (!already_lifted && memory_reader.QueryMemory(ip).IsNonExecutable()) {
+                LOG(WARNING) << "Block at IP: 0x" << std::hex << ip << " is not executable, adding fault stub";
+                addr_to_func_map.emplace_back(ip, "__rt_block_fault");
+                already_lifted = true;
+            }
+            if (!already_lifted) {
                 // First lift the basic block
+                // A target inside a lifted block splits it instead of lifting its tail again
                 std::unique_ptr<llvm::Module> lifted_module;
-                if (!Recycle::liftBasicBlock(lifted_module, memory_reader, *llvm_context, ip)) {
+                LiftedBlockMap::Block head, tail;
+                std::vector<uint64_t> callees;
+                if (block_map.Split(ip, head, tail)) {
+                    if (!Recycle::liftSplitBlock(lifted_module, lifted_modules, lifting_context, addr_to_func_map, head, tail)) {
+                        return 1;
+                    }
+                } else if (options.getLiftFunctions()) {
+                    if (!Recycle::liftFunctionTrace(lifted_module, memory_reader, lifting_context, addr_to_func_map, ip)) {
+                        return 1;
+                    }
+                } else if (!Recycle::liftBasicBlock(lifted_module, memory_reader, lifting_context, disassembler, block_map,
+                                                    addr_to_func_map, options.getSuperblockMaxInstructions(), ip,
+                                                    callees)) {
                     LOG(ERROR) << "Failed to lift basic block at IP: 0x" << std::hex << ip;
                     return 1;
+                } else {
+                    Recycle::addCalleeFunctions(addr_to_func_map, callees);
+                    Recycle::liftJumpTableTargets(memory_reader, lifting_context, disassembler, block_map,
+                                                  options.getSuperblockMaxInstructions(), lifted_modules,
+                                                  addr_to_func_map, ip);
                 }
                 // write lifted module to file
                 const auto filename_prefix = Recycle::getFilenamePrefix("lifted", iteration_count);
@@ -423,6 +1899,8 @@ int main(int argc, char* argv[]) {
 
                 lifted_modules.push_back(std::move(lifted_module));
             }
+            // Code is only viewed while decoding and lifting
+            memory_reader.ReleaseViews();
             // todo: refactoring artifact 
             if (missing_memory.size() > 0) {
                 missing_memory.clear();
@@ -431,7 +1909,10 @@ int main(int argc, char* argv[]) {
             // Merge all lifted modules into new memory module
             std::unique_ptr<llvm::Module> merged_module = std::make_unique<llvm::Module>("merged_module", *llvm_context);
             for (const auto& module : lifted_modules) {
-                BitcodeManipulation::MergeModules(*merged_module, *module);
+                if (!BitcodeManipulation::MergeModules(*merged_module, *module)) {
+                    LOG(ERROR) << "Failed to merge the lifted modules";
+                    return 1;
+                }
             }
 
             // Then process the lifted block
@@ -443,33 +1924,35 @@ int main(int argc, char* argv[]) {
             }
 
             // Process missing memory
-            if (!Recycle::processMissingMemory(merged_module, added_memory, memory_reader)) {
+            if (!Recycle::processMissingMemory(merged_module, added_memory, materialized_memory, memory_reader)) {
                 LOG(ERROR) << "Failed to process missing memory";
                 return 1;
             }
 
-            // Create get saved memory ptr function
-            if (BitcodeManipulation::CreateGetSavedMemoryPtr(*merged_module) == nullptr) {
-                LOG(ERROR) << "Failed to create get saved memory ptr";
+            // Ranges known to be unmapped get fault stubs
+            const auto unmapped_ranges = memory_reader.GetUnmappedRanges();
+            const std::vector<std::pair<uint64_t, uint64_t>> fault_ranges(unmapped_ranges.begin(), unmapped_ranges.end());
+
+            // Read-ahead needs the pages a run accessed, only the copy that is
+            // run records them so the output carries no tracking stores
+            std::unique_ptr<llvm::Module> tracked_module;
+            if (options.getReadAheadMaxPages() > 0) {
+                tracked_module = llvm::CloneModule(*merged_module);
+                if (!Recycle::optimizeMergedModule(*tracked_module, fault_ranges, true, options.getStripUnreachable(),
+                                                   iteration_count, false)) {
+                    return 1;
+                }
+            }
+            if (!Recycle::optimizeMergedModule(*merged_module, fault_ranges, false, options.getStripUnreachable(),
+                                               iteration_count, true)) {
                 return 1;
             }
 
-            // optimize module
-            const auto exclustion = std::vector<std::string>{"main"};
-            BitcodeManipulation::ReplaceFunction(*merged_module, "__remill_write_memory_64", "__remill_write_memory_64_opt");
-            BitcodeManipulation::RemoveOptNoneAttribute(*merged_module, exclustion);
-            BitcodeManipulation::MakeSymbolsInternal(*merged_module, exclustion);
-            BitcodeManipulation::MakeFunctionsInline(*merged_module, exclustion);
-            BitcodeManipulation::DumpModule(*merged_module, Recycle::getFilenamePrefix("opt_pre", iteration_count));
-            BitcodeManipulation::OptimizeModule(*merged_module, 3); // Calling optimize module twice is intentional
-            BitcodeManipulation::DumpModule(*merged_module, Recycle::getFilenamePrefix("opt", iteration_count));
-            BitcodeManipulation::OptimizeModule(*merged_module, 3); // Calling optimize module twice is intentional
-            BitcodeManipulation::DumpModule(*merged_module, Recycle::getFilenamePrefix("opt2", iteration_count));
-
             // Execute JIT code
             const auto filename_prefix = Recycle::getFilenamePrefix("merged", iteration_count);
-            if (!Recycle::executeJITCode(merged_module, ip, entry_point, filename_prefix, 
-                                       missing_memory, added_memory, missing_blocks)) {
+            if (!Recycle::executeJITCode(merged_module, tracked_module.get(), ip, entry_point, filename_prefix,
+                                       missing_memory, added_memory, missing_blocks,
+                                       memory_reader, read_ahead)) {
                 return 1;
             }
             
@@ -480,6 +1963,18 @@ int main(int argc, char* argv[]) {
         }
 
         LOG(INFO) << "Program lifted successfully, " << iteration_count << " iterations completed";
+        read_ahead.Report();
+        LOG(INFO) << "Decode cache: " << std::dec << decode_cache.GetSize() << " instructions, "
+                  << decode_cache.GetHits() << " hits, " << decode_cache.GetMisses() << " misses, hit rate "
+                  << static_cast<int>(decode_cache.GetHitRate() * 100) << "%";
+        LOG(INFO) << "Lifted blocks: " << std::dec << block_map.GetBlockCount() << ", "
+                  << block_map.GetSplitCount() << " split at a later target";
+        if (lifting_context.GetDiskCache()) {
+            LOG(INFO) << "Lift cache: " << std::dec << lift_cache->GetHits() << " hits, " << lift_cache->GetMisses()
+                      << " misses, hit rate " << static_cast<int>(lift_cache->GetHitRate() * 100) << "%, "
+                      << lift_cache->GetStores() << " stored, " << lift_cache->GetEvictions() << " evicted, "
+                      << lift_cache->GetEntryCount() << " blocks in " << lift_cache->GetSize() / 1024 << " KiB";
+        }
 
         //// create arrow function for RuntimeCallback
         //auto runtime_callback = [](void* s, uint64_t* pc, void** memory) {
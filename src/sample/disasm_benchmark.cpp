@@ -0,0 +1,305 @@
+// Disassembly throughput benchmark. Decodes synthetic code and, with
+// --minidump, the executable sections of a dump, through XEDDisassembler and
+// BasicBlockDisassembler with and without text formatting. Every case runs
+// --iterations times and reports instructions/s and bytes/s percentiles as
+// JSON lines or CSV.
+#include "Disasm/BasicBlockDisassembler.h"
+#include "Disasm/XEDDisassembler.h"
+#include "Minidump/MinidumpContext.h"
+
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+DEFINE_string(minidump, "", "Also benchmark the executable sections of this minidump");
+DEFINE_uint32(iterations, 20, "Timed runs of every case, percentiles are taken over these");
+DEFINE_uint64(synthetic_bytes, 1 << 20, "Size of the generated code buffer");
+DEFINE_uint64(max_region_bytes, 16 << 20, "Maximum number of dump bytes benchmarked");
+DEFINE_string(format, "json", "Output format, json (one object per line) or csv");
+DEFINE_string(output, "", "Write results to this file instead of stdout");
+
+namespace {
+
+struct Input {
+    std::string name;
+    uint64_t address;
+    std::vector<uint8_t> bytes;
+};
+
+// Work done by one run of a case
+struct RunStats {
+    size_t instructions = 0;
+    size_t bytes = 0;
+    size_t text_bytes = 0;  // Formatted text, also keeps formatting from being optimized away
+};
+
+struct Case {
+    std::string name;
+    std::function<RunStats(const Input&)> run;
+};
+
+struct Percentiles {
+    double min, p50, p90, p99, max;
+};
+
+// Encodings common in compiled x64 code, including terminators so that
+// blocks stay short
+const std::vector<std::vector<uint8_t>> kEncodings = {
+    {0x48, 0x89, 0xc8},                             // mov rax, rcx
+    {0x48, 0x8b, 0x44, 0x24, 0x28},                 // mov rax, [rsp+0x28]
+    {0x48, 0x89, 0x5c, 0x24, 0x08},                 // mov [rsp+8], rbx
+    {0x48, 0x8d, 0x0d, 0x10, 0x20, 0x00, 0x00},     // lea rcx, [rip+0x2010]
+    {0x48, 0x83, 0xec, 0x28},                       // sub rsp, 0x28
+    {0x48, 0x01, 0xd0},                             // add rax, rdx
+    {0x85, 0xc0},                                   // test eax, eax
+    {0x83, 0xf9, 0x05},                             // cmp ecx, 5
+    {0x0f, 0xb6, 0x04, 0x0a},                       // movzx eax, byte [rdx+rcx]
+    {0x53},                                         // push rbx
+    {0x5b},                                         // pop rbx
+    {0xc5, 0xf8, 0x28, 0xc1},                       // vmovaps xmm0, xmm1
+    {0x74, 0x10},                                   // je +0x10
+    {0x0f, 0x85, 0x00, 0x01, 0x00, 0x00},           // jne +0x100
+    {0xe8, 0x00, 0x10, 0x00, 0x00},                 // call +0x1000
+    {0xeb, 0x08},                                   // jmp +8
+    {0xc3},                                         // ret
+};
+
+Input MakeSyntheticInput(size_t size) {
+    Input input{"synthetic", 0x140001000, {}};
+    input.bytes.reserve(size + 16);
+    std::mt19937 random(1234);
+    // Terminators are the last five encodings, about one instruction in five
+    std::discrete_distribution<size_t> pick({6, 6, 6, 4, 3, 6, 4, 3, 2, 3, 3, 2, 3, 2, 3, 1, 2});
+    while (input.bytes.size() < size) {
+        const auto& encoding = kEncodings[pick(random)];
+        input.bytes.insert(input.bytes.end(), encoding.begin(), encoding.end());
+    }
+    return input;
+}
+
+bool LoadDumpInputs(const std::string& path, size_t max_bytes, std::vector<Input>& inputs) {
+    MinidumpContext::MinidumpContext minidump(path);
+    if (!minidump.Initialize()) {
+        LOG(ERROR) << "Failed to initialize minidump context";
+        return false;
+    }
+
+    size_t total = 0;
+    for (const auto& module : minidump.GetModules()) {
+        for (const auto& section : module.sections) {
+            if (!section.IsExecutable() || total >= max_bytes) {
+                continue;
+            }
+            const auto bytes = minidump.TryReadMemory(section.address, std::min<size_t>(section.size, max_bytes - total));
+            if (bytes.data.empty()) {
+                continue;
+            }
+            total += bytes.data.size();
+            inputs.push_back({"dump:" + module.name + ":" + section.name, section.address, bytes.data});
+        }
+    }
+
+    // Without section headers fall back to the region around the instruction pointer
+    if (total == 0) {
+        const auto info = minidump.QueryMemory(minidump.GetInstructionPointer());
+        const auto bytes = minidump.TryReadMemory(info.region_base, std::min<size_t>(info.region_size, max_bytes));
+        if (!bytes.data.empty()) {
+            inputs.push_back({"dump:rip_region", info.region_base, bytes.data});
+        }
+    }
+    return true;
+}
+
+// Linear sweep one instruction at a time, undecodable bytes are skipped
+RunStats RunDecode(const Input& input, bool format) {
+    const auto& disasm = XEDDisassembler::Get();
+    RunStats stats;
+    for (size_t offset = 0; offset < input.bytes.size();) {
+        const auto inst = disasm.DecodeInstruction(input.bytes.data() + offset, input.bytes.size() - offset,
+                                                   input.address + offset);
+        if (inst.length == 0) {
+            offset++;
+            continue;
+        }
+        if (format) {
+            stats.text_bytes += disasm.FormatInstruction(inst).size();
+        }
+        stats.instructions++;
+        stats.bytes += inst.length;
+        offset += inst.length;
+    }
+    return stats;
+}
+
+// Block after block into a stack buffer, the next block starts where the
+// previous one ended
+RunStats RunBlocks(const Input& input, bool format) {
+    BasicBlockDisassembler disassembler;
+    std::array<DecodedInstruction, 32> buffer;
+    RunStats stats;
+    for (size_t offset = 0; offset < input.bytes.size();) {
+        const size_t count = disassembler.DisassembleBlock(input.bytes.data() + offset, input.bytes.size() - offset,
+                                                           input.address + offset, buffer);
+        if (count == 0) {
+            offset++;
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (format) {
+                stats.text_bytes += XEDDisassembler::Get().FormatInstruction(buffer[i]).size();
+            }
+            stats.bytes += buffer[i].length;
+        }
+        stats.instructions += count;
+        offset = buffer[count - 1].GetNextAddress() - input.address;
+    }
+    return stats;
+}
+
+Percentiles GetPercentiles(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto at = [&values](double fraction) {
+        return values[std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5))];
+    };
+    return {values.front(), at(0.5), at(0.9), at(0.99), values.back()};
+}
+
+void WriteCsvHeader(std::ostream& out) {
+    out << "input,case,iterations,instructions,bytes,text_bytes,"
+           "inst_per_sec_min,inst_per_sec_p50,inst_per_sec_p90,inst_per_sec_p99,inst_per_sec_max,"
+           "bytes_per_sec_min,bytes_per_sec_p50,bytes_per_sec_p90,bytes_per_sec_p99,bytes_per_sec_max\n";
+}
+
+// Module paths may hold quotes, backslashes or commas
+std::string EscapeJson(const std::string& text) {
+    std::string escaped;
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string QuoteCsv(const std::string& text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void WriteResult(std::ostream& out, const std::string& format, const Input& input, const Case& bench_case,
+                 const RunStats& stats, const Percentiles& inst_rate, const Percentiles& byte_rate) {
+    const auto write_json = [&out](const char* name, const Percentiles& p) {
+        out << "\"" << name << "\":{\"min\":" << p.min << ",\"p50\":" << p.p50 << ",\"p90\":" << p.p90
+            << ",\"p99\":" << p.p99 << ",\"max\":" << p.max << "}";
+    };
+    const auto write_csv = [&out](const Percentiles& p) {
+        out << p.min << "," << p.p50 << "," << p.p90 << "," << p.p99 << "," << p.max;
+    };
+
+    if (format == "csv") {
+        out << QuoteCsv(input.name) << "," << QuoteCsv(bench_case.name) << "," << FLAGS_iterations << ","
+            << stats.instructions << "," << stats.bytes << "," << stats.text_bytes << ",";
+        write_csv(inst_rate);
+        out << ",";
+        write_csv(byte_rate);
+        out << "\n";
+        return;
+    }
+    out << "{\"input\":\"" << EscapeJson(input.name) << "\",\"case\":\"" << EscapeJson(bench_case.name)
+        << "\",\"iterations\":" << FLAGS_iterations << ",\"instructions\":" << stats.instructions
+        << ",\"bytes\":" << stats.bytes << ",\"text_bytes\":" << stats.text_bytes << ",";
+    write_json("inst_per_sec", inst_rate);
+    out << ",";
+    write_json("bytes_per_sec", byte_rate);
+    out << "}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage(std::string("Usage: ") + argv[0] + " [--minidump=<path>] [--format=json|csv] [options]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = true;
+
+    if (FLAGS_format != "json" && FLAGS_format != "csv") {
+        std::cerr << "--format must be json or csv\n";
+        return 1;
+    }
+    if (FLAGS_iterations == 0) {
+        std::cerr << "--iterations must be at least 1\n";
+        return 1;
+    }
+
+    std::vector<Input> inputs = {MakeSyntheticInput(FLAGS_synthetic_bytes)};
+    if (!FLAGS_minidump.empty() && !LoadDumpInputs(FLAGS_minidump, FLAGS_max_region_bytes, inputs)) {
+        std::cerr << "Failed to load " << FLAGS_minidump << "\n";
+        return 1;
+    }
+
+    const std::vector<Case> cases = {
+        {"decode", [](const Input& input) { return RunDecode(input, false); }},
+        {"decode_format", [](const Input& input) { return RunDecode(input, true); }},
+        {"block", [](const Input& input) { return RunBlocks(input, false); }},
+        {"block_format", [](const Input& input) { return RunBlocks(input, true); }},
+    };
+
+    std::ofstream file;
+    if (!FLAGS_output.empty()) {
+        file.open(FLAGS_output);
+        if (!file) {
+            std::cerr << "Could not open " << FLAGS_output << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = FLAGS_output.empty() ? std::cout : file;
+    if (FLAGS_format == "csv") {
+        WriteCsvHeader(out);
+    }
+
+    // Failed decodes in data between functions would flood the output, load
+    // errors above are still logged
+    FLAGS_minloglevel = google::GLOG_FATAL;
+    for (const auto& input : inputs) {
+        for (const auto& bench_case : cases) {
+            // One untimed run warms the caches and the XED tables
+            RunStats stats = bench_case.run(input);
+
+            std::vector<double> inst_rates;
+            std::vector<double> byte_rates;
+            for (uint32_t i = 0; i < FLAGS_iterations; i++) {
+                const auto start = std::chrono::steady_clock::now();
+                stats = bench_case.run(input);
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                const double seconds = std::max(elapsed.count(), 1e-9);
+                inst_rates.push_back(stats.instructions / seconds);
+                byte_rates.push_back(stats.bytes / seconds);
+            }
+            WriteResult(out, FLAGS_format, input, bench_case, stats, GetPercentiles(inst_rates), GetPercentiles(byte_rates));
+        }
+    }
+    return 0;
+}
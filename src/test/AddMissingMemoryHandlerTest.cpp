@@ -302,4 +302,57 @@ TEST_F(AddMissingMemoryHandlerTest, TestMemoryReadBoundaryCross32) {
         const auto& missing_memory = Runtime::MissingMemoryTracker::GetMissingMemory();
         ASSERT_EQ(missing_memory.size(), 0);
     }
-} 
\ No newline at end of file
+} 
+TEST_F(AddMissingMemoryHandlerTest, TestFaultRangeAtTopOfAddressSpace) {
+    const uint64_t PAGE_SIZE = PREBUILT_MEMORY_CELL_SIZE;
+    const uint64_t TOP_PAGE = ~(PAGE_SIZE - 1);
+    auto* Int64Ty = llvm::Type::getInt64Ty(*Context);
+
+    // Empty cell array, as Utils.ll brings it along
+    auto* CellTy = llvm::StructType::get(Int64Ty, llvm::ArrayType::get(llvm::Type::getInt8Ty(*Context), PAGE_SIZE));
+    auto* CellsTy = llvm::ArrayType::get(CellTy, 0);
+    new llvm::GlobalVariable(*Module, CellsTy, false, llvm::GlobalValue::ExternalLinkage,
+                             llvm::ConstantAggregateZero::get(CellsTy), "GlobalMemoryCells64");
+    std::vector<uint8_t> page(PAGE_SIZE, 0x5a);
+    ASSERT_TRUE(BitcodeManipulation::AddMissingMemory(*Module, 0x1000, page));
+
+    // The range cache clamps a gap running to the end of the address space to UINT64_MAX
+    const std::vector<std::pair<uint64_t, uint64_t>> fault_ranges = {{0, 0x1000}, {TOP_PAGE - PAGE_SIZE, UINT64_MAX}};
+    auto* GetMemoryPtr = BitcodeManipulation::CreateGetSavedMemoryPtr(*Module, false, fault_ranges);
+    ASSERT_NE(GetMemoryPtr, nullptr);
+
+    // One function per looked up address, returning what the lookup hands out
+    const auto create_lookup = [&](const std::string& name, uint64_t addr) {
+        auto* Func = llvm::Function::Create(llvm::FunctionType::get(Int64Ty, false),
+                                            llvm::GlobalValue::ExternalLinkage, name, Module.get());
+        llvm::IRBuilder<> Builder(llvm::BasicBlock::Create(*Context, "entry", Func));
+        Builder.CreateRet(Builder.CreateCall(GetMemoryPtr, {llvm::ConstantInt::get(Int64Ty, addr)}));
+    };
+    create_lookup("lookup_top", TOP_PAGE + 0x800);
+    create_lookup("lookup_low", 0x10);
+    create_lookup("lookup_mapped", 0x1010);
+    create_lookup("lookup_missing", TOP_PAGE - 2 * PAGE_SIZE);
+    ASSERT_FALSE(llvm::verifyModule(*Module, &llvm::errs()));
+
+    JITEngine jit;
+    ASSERT_TRUE(jit.Initialize(std::move(Module)));
+    Runtime::MemoryFaultTracker::ClearFaults();
+
+    // Both ends of the address space fault and are served from the zero page
+    uintptr_t result = 0;
+    ASSERT_TRUE(jit.ExecuteFunction("lookup_top", &result));
+    ASSERT_NE(result, 0);
+    ASSERT_EQ(result, jit.GetGlobalAddress("FaultMemoryPage"));
+    ASSERT_TRUE(jit.ExecuteFunction("lookup_low", &result));
+    ASSERT_EQ(result, jit.GetGlobalAddress("FaultMemoryPage"));
+    ASSERT_EQ(Runtime::MemoryFaultTracker::GetFaultCount(), 2);
+
+    // Mapped pages are still found, addresses outside every range stay missing
+    ASSERT_TRUE(jit.ExecuteFunction("lookup_mapped", &result));
+    ASSERT_NE(result, 0);
+    ASSERT_EQ(*reinterpret_cast<const uint8_t*>(result), 0x5a);
+    ASSERT_TRUE(jit.ExecuteFunction("lookup_missing", &result));
+    ASSERT_EQ(result, 0);
+    ASSERT_EQ(Runtime::MemoryFaultTracker::GetFaultCount(), 2);
+    Runtime::MemoryFaultTracker::ClearFaults();
+}
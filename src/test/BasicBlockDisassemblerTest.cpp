@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "Disasm/BasicBlockDisassembler.h"
+#include <glog/logging.h>
+
+#include <array>
+#include <vector>
+
+namespace {
+    // Views end at every 4 byte "page", nothing past the end is readable
+    class PagedByteSource : public ByteSource {
+    public:
+        PagedByteSource(std::vector<uint8_t> bytes, uint64_t base) : bytes(std::move(bytes)), base(base) {}
+
+        llvm::ArrayRef<uint8_t> Fetch(uint64_t address, size_t size) override {
+            if (address < base || address - base >= bytes.size()) {
+                return {};
+            }
+            const size_t offset = address - base;
+            const size_t page_left = 4 - address % 4;
+            return llvm::ArrayRef<uint8_t>(bytes).slice(offset, std::min({size, page_left, bytes.size() - offset}));
+        }
+
+    private:
+        std::vector<uint8_t> bytes;
+        uint64_t base;
+    };
+}
+
+class BasicBlockDisassemblerTest : public ::testing::Test {
+protected:
+    // nop; nop; je +3; ret
+    const std::vector<uint8_t> code = {0x90, 0x90, 0x74, 0x03, 0xc3};
+    // nop; nop; nop; je +3 across the first 4 byte page boundary; ret
+    const std::vector<uint8_t> paged_code = {0x90, 0x90, 0x90, 0x74, 0x03, 0xc3};
+
+    BasicBlockDisassembler disassembler;
+    std::array<DecodedInstruction, 8> buffer;
+};
+
+TEST_F(BasicBlockDisassemblerTest, TestDecodeIntoBuffer) {
+    const auto count = disassembler.DisassembleBlock(code.data(), code.size(), 0x1000, buffer);
+
+    // The conditional branch ends the block
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(buffer[0].address, 0x1000);
+    ASSERT_EQ(buffer[0].length, 1);
+    ASSERT_FALSE(buffer[0].IsTerminator());
+    ASSERT_EQ(buffer[2].address, 0x1002);
+    ASSERT_TRUE(buffer[2].IsCondBranch());
+    ASSERT_TRUE(buffer[2].HasTarget());
+    ASSERT_EQ(buffer[2].target, 0x1007);
+    ASSERT_EQ(buffer[2].GetBytes(), llvm::ArrayRef<uint8_t>(code).slice(2, 2));
+}
+
+TEST_F(BasicBlockDisassemblerTest, TestBufferLimitsBlock) {
+    const uint8_t nops[] = {0x90, 0x90, 0x90, 0x90, 0xc3};
+    std::array<DecodedInstruction, 2> small;
+    ASSERT_EQ(disassembler.DisassembleBlock(nops, sizeof(nops), 0x1000, small), 2);
+
+    // The vector form still returns the whole block
+    const auto instructions = disassembler.DisassembleBlock(nops, sizeof(nops), 0x1000);
+    ASSERT_EQ(instructions.size(), 5);
+    ASSERT_TRUE(instructions.back().IsRet());
+}
+
+TEST_F(BasicBlockDisassemblerTest, TestRevisitIsCacheWalk) {
+    DecodeCache cache;
+    BasicBlockDisassembler cached(32, &cache);
+    ASSERT_EQ(cached.DisassembleBlock(code.data(), code.size(), 0x1000, buffer), 3);
+    ASSERT_EQ(cache.GetHits(), 0);
+
+    // Entering in the middle of the block reuses the decoded tail
+    ASSERT_EQ(cached.DisassembleBlock(code.data() + 1, code.size() - 1, 0x1001, buffer), 2);
+    ASSERT_EQ(cache.GetHits(), 2);
+    ASSERT_TRUE(buffer[1].IsCondBranch());
+    ASSERT_EQ(cache.GetSize(), 3);
+}
+
+TEST_F(BasicBlockDisassemblerTest, TestByteSourceCrossesPages) {
+    PagedByteSource source(paged_code, 0x1000);
+    ASSERT_EQ(disassembler.DisassembleBlock(source, 0x1000, buffer), 4);
+    ASSERT_EQ(buffer[3].address, 0x1003);
+    ASSERT_EQ(buffer[3].length, 2);
+    ASSERT_TRUE(buffer[3].IsCondBranch());
+    ASSERT_EQ(buffer[3].target, 0x1008);
+
+    // Running off the readable bytes ends the block
+    PagedByteSource tail({0x90, 0x90}, 0x1000);
+    ASSERT_EQ(disassembler.DisassembleBlock(tail, 0x1000, buffer), 2);
+    ASSERT_EQ(disassembler.DisassembleBlock(tail, 0x2000, buffer), 0);
+}
+
+TEST_F(BasicBlockDisassemblerTest, TestStopAtLiftedBlock) {
+    // A block lifted before at 0x1002
+    PagedByteSource source(paged_code, 0x1000);
+    ASSERT_EQ(disassembler.DisassembleBlock(source, 0x1000, buffer, 0x1002), 2);
+    ASSERT_FALSE(buffer[1].IsTerminator());
+    ASSERT_EQ(buffer[1].GetNextAddress(), 0x1002);
+
+    // A stop at or before the start does not cut the block
+    ASSERT_EQ(disassembler.DisassembleBlock(source, 0x1002, buffer, 0x1002), 2);
+    ASSERT_EQ(disassembler.DisassembleBlock(source, 0x1003, buffer, 0x1000), 1);
+}
+
+TEST_F(BasicBlockDisassemblerTest, TestSuperblockFollowsJumpsAndCalls) {
+    // 0x1000: nop; jmp 0x1010
+    // 0x1010: call 0x1020; je 0x1000
+    // 0x1020: nop; ret
+    std::vector<uint8_t> superblock_code(0x30, 0xcc);
+    const std::vector<uint8_t> entry = {0x90, 0xeb, 0x0d};
+    const std::vector<uint8_t> caller = {0xe8, 0x0b, 0x00, 0x00, 0x00, 0x74, 0xe9};
+    const std::vector<uint8_t> callee = {0x90, 0xc3};
+    std::copy(entry.begin(), entry.end(), superblock_code.begin());
+    std::copy(caller.begin(), caller.end(), superblock_code.begin() + 0x10);
+    std::copy(callee.begin(), callee.end(), superblock_code.begin() + 0x20);
+    MemoryByteSource source(superblock_code.data(), superblock_code.size(), 0x1000);
+
+    // Entry block first, then the jump target, the callee and the return address
+    std::vector<uint64_t> callees;
+    const size_t count = disassembler.DisassembleSuperblock(source, 0x1000, buffer, callees);
+    ASSERT_EQ(count, 6);
+    const std::array<uint64_t, 6> expected = {0x1000, 0x1001, 0x1010, 0x1020, 0x1021, 0x1015};
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(buffer[i].address, expected[i]);
+    }
+    ASSERT_EQ(callees, std::vector<uint64_t>{0x1020});
+
+    // The budget cuts the superblock short
+    callees.clear();
+    std::array<DecodedInstruction, 3> small;
+    ASSERT_EQ(disassembler.DisassembleSuperblock(source, 0x1000, small, callees), 3);
+    ASSERT_EQ(small[2].address, 0x1010);
+    ASSERT_TRUE(callees.empty());
+
+    // A callee lifted before is not followed again
+    const auto is_known = [](uint64_t address) { return address == 0x1020; };
+    ASSERT_EQ(disassembler.DisassembleSuperblock(source, 0x1000, buffer, callees, is_known), 4);
+    ASSERT_EQ(buffer[3].address, 0x1015);
+    ASSERT_TRUE(callees.empty());
+}
+
+TEST_F(BasicBlockDisassemblerTest, TestInstructionByteSource) {
+    // Two blocks with a gap between them: nop; jmp +0x0d and nop; ret
+    const std::vector<uint8_t> entry_code = {0x90, 0xeb, 0x0d};
+    const std::vector<uint8_t> target = {0x90, 0xc3};
+    auto instructions = disassembler.DisassembleBlock(target.data(), target.size(), 0x1010);
+    const auto entry = disassembler.DisassembleBlock(entry_code.data(), entry_code.size(), 0x1000);
+    instructions.insert(instructions.end(), entry.begin(), entry.end());
+    InstructionByteSource source(instructions);
+
+    // Views stop at the end of the instruction
+    auto bytes = source.Fetch(0x1000, 16);
+    ASSERT_EQ(bytes.size(), 1);
+    ASSERT_EQ(bytes[0], 0x90);
+    bytes = source.Fetch(0x1002, 16);
+    ASSERT_EQ(bytes.size(), 1);
+    ASSERT_EQ(bytes[0], 0x0d);
+    bytes = source.Fetch(0x1011, 16);
+    ASSERT_EQ(bytes.size(), 1);
+    ASSERT_EQ(bytes[0], 0xc3);
+
+    // Nothing in the gap, before or after
+    ASSERT_TRUE(source.Fetch(0x1003, 16).empty());
+    ASSERT_TRUE(source.Fetch(0xfff, 16).empty());
+    ASSERT_TRUE(source.Fetch(0x1012, 16).empty());
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "Disasm/DecodeCache.h"
+#include <glog/logging.h>
+
+class DecodeCacheTest : public ::testing::Test {
+protected:
+    static DecodedInstruction MakeInstruction(uint64_t address, uint8_t length) {
+        DecodedInstruction decoded;
+        decoded.address = address;
+        decoded.length = length;
+        return decoded;
+    }
+
+    DecodeCache cache;
+    DecodedInstruction inst;  // Lookup result
+};
+
+TEST_F(DecodeCacheTest, TestLookupCountsHits) {
+    ASSERT_FALSE(cache.Lookup(0x1000, inst));
+
+    cache.Insert(MakeInstruction(0x1000, 3));
+    ASSERT_TRUE(cache.Lookup(0x1000, inst));
+    ASSERT_EQ(inst.length, 3);
+    ASSERT_TRUE(cache.Lookup(0x1000, inst));
+
+    ASSERT_EQ(cache.GetHits(), 2);
+    ASSERT_EQ(cache.GetMisses(), 1);
+    ASSERT_NEAR(cache.GetHitRate(), 2.0 / 3.0, 1e-9);
+
+    // Failed decodes are not cached
+    cache.Insert(MakeInstruction(0x2000, 0));
+    ASSERT_EQ(cache.GetSize(), 1);
+}
+
+TEST_F(DecodeCacheTest, TestInvalidatePage) {
+    cache.Insert(MakeInstruction(0x1000, 1));
+    cache.Insert(MakeInstruction(0x1ffe, 5));   // Runs into the next page
+    cache.Insert(MakeInstruction(0x2004, 2));
+    cache.Insert(MakeInstruction(0x3000, 2));
+
+    // The page after the spanning instruction takes it along
+    cache.InvalidatePage(0x2abc);
+    ASSERT_TRUE(cache.Lookup(0x1000, inst));
+    ASSERT_FALSE(cache.Lookup(0x1ffe, inst));
+    ASSERT_FALSE(cache.Lookup(0x2004, inst));
+    ASSERT_TRUE(cache.Lookup(0x3000, inst));
+    ASSERT_EQ(cache.GetSize(), 2);
+
+    cache.InvalidatePage(0x1000);
+    ASSERT_FALSE(cache.Lookup(0x1000, inst));
+    ASSERT_EQ(cache.GetSize(), 1);
+}
+
+TEST_F(DecodeCacheTest, TestReinsertAfterInvalidate) {
+    cache.Insert(MakeInstruction(0x1ffe, 5));
+    cache.InvalidatePage(0x2000);
+
+    // Decoded again from the new bytes, either page still drops it
+    cache.Insert(MakeInstruction(0x1ffe, 4));
+    ASSERT_TRUE(cache.Lookup(0x1ffe, inst));
+    ASSERT_EQ(inst.length, 4);
+    cache.InvalidatePage(0x1000);
+    ASSERT_FALSE(cache.Lookup(0x1ffe, inst));
+    ASSERT_EQ(cache.GetSize(), 0);
+
+    cache.Insert(MakeInstruction(0x1ffe, 4));
+    cache.InvalidatePage(0x2000);
+    ASSERT_EQ(cache.GetSize(), 0);
+}
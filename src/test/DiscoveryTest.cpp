@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+#include "Discovery/DiscoverySession.h"
+#include "Discovery/JumpTable.h"
+#include "Discovery/LinearSweep.h"
+#include "Discovery/ThreadPool.h"
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+class DiscoveryTest : public ::testing::Test {
+protected:
+    using Kind = InstructionOperands::Kind;
+    enum : uint16_t { kRax = 1, kRcx, kRdx };
+
+    // Instruction window built from hand-made operands
+    struct Window {
+        std::vector<DecodedInstruction> instructions;
+        std::vector<InstructionOperands> operands;
+
+        InstructionOperands& Add(Kind kind, std::vector<uint16_t> regs, uint8_t flags = 0) {
+            DecodedInstruction inst;
+            inst.address = 0x1000 + instructions.size() * 4;
+            inst.length = 4;
+            inst.flags = flags;
+            instructions.push_back(inst);
+
+            InstructionOperands ops;
+            ops.kind = kind;
+            for (const auto reg : regs) {
+                ops.regs[ops.reg_count++] = reg;
+            }
+            operands.push_back(ops);
+            return operands.back();
+        }
+    };
+
+    static constexpr uint64_t kBase = 0x1000;
+
+    // 0x1000: je 0x1005
+    // 0x1002: nop
+    // 0x1003: jmp 0x1005
+    // 0x1005: ret
+    const std::vector<uint8_t> code = {0x74, 0x03, 0x90, 0xeb, 0x00, 0xc3};
+
+    // Reads the code above, nothing around it
+    Discovery::CodeReader MakeCodeReader() const {
+        return [this](uint64_t address, size_t size) -> llvm::ArrayRef<uint8_t> {
+            if (address < kBase || address >= kBase + code.size()) {
+                return {};
+            }
+            return llvm::ArrayRef<uint8_t>(code).slice(address - kBase);
+        };
+    }
+
+    static std::vector<uint64_t> GetAddresses(const std::vector<Discovery::DiscoveredBlock>& blocks) {
+        std::vector<uint64_t> result;
+        for (const auto& block : blocks) {
+            result.push_back(block.address);
+        }
+        return result;
+    }
+};
+
+TEST_F(DiscoveryTest, TestThreadPoolRunsAllTasks) {
+    std::atomic<size_t> done{0};
+    Discovery::ThreadPool pool(4);
+    for (int i = 0; i < 100; i++) {
+        pool.Submit([&done] { done++; });
+    }
+    pool.Wait();
+    ASSERT_EQ(done, 100);
+}
+
+TEST_F(DiscoveryTest, TestBlockIsClaimedOnce) {
+    Discovery::LiftedBlockCache cache;
+    std::atomic<size_t> claimed{0};
+    {
+        Discovery::ThreadPool pool(8);
+        for (int i = 0; i < 64; i++) {
+            pool.Submit([&] {
+                for (uint64_t address = 0x1000; address < 0x1100; address++) {
+                    if (cache.Claim(address)) {
+                        claimed++;
+                        cache.Finish(address, address % 2 == 0);
+                    }
+                }
+            });
+        }
+        pool.Wait();
+    }
+    ASSERT_EQ(claimed, 0x100);
+    ASSERT_EQ(cache.GetLiftedCount(), 0x80);
+    ASSERT_TRUE(cache.IsLifted(0x1000));
+    ASSERT_FALSE(cache.IsLifted(0x1001));
+}
+
+TEST_F(DiscoveryTest, TestSessionsShareBlocks) {
+    const auto read_code = MakeCodeReader();
+    std::mutex lifted_mutex;
+    std::vector<uint64_t> lifted;
+    const auto lift_block = [&](llvm::ArrayRef<DecodedInstruction> instructions, uint64_t address) {
+        std::lock_guard<std::mutex> lock(lifted_mutex);
+        lifted.push_back(address);
+        return true;
+    };
+
+    // Two threads stopped in the same function
+    Discovery::SharedCaches caches;
+    Discovery::DiscoverySession first(1, kBase, caches, read_code, lift_block, 100);
+    Discovery::DiscoverySession second(2, kBase, caches, read_code, lift_block, 100);
+    {
+        Discovery::ThreadPool pool(2);
+        pool.Submit([&] { first.Run(); });
+        pool.Submit([&] { second.Run(); });
+        pool.Wait();
+    }
+
+    std::sort(lifted.begin(), lifted.end());
+    ASSERT_EQ(lifted, (std::vector<uint64_t>{0x1000, 0x1002, 0x1005}));
+    ASSERT_EQ(first.GetBlocksLifted() + second.GetBlocksLifted(), 3);
+    ASSERT_EQ(first.GetBlocksShared() + second.GetBlocksShared(), 3);
+    ASSERT_EQ(caches.lifted.GetLiftedBlocks(), lifted);
+}
+
+TEST_F(DiscoveryTest, TestStaticDiscovery) {
+    const auto read_code = MakeCodeReader();
+
+    // Branch targets are walked before fallthroughs
+    DecodeCache cache;
+    Discovery::StaticDiscovery discovery(cache, read_code, 100);
+    const auto blocks = discovery.Run(kBase);
+    ASSERT_EQ(GetAddresses(blocks), (std::vector<uint64_t>{0x1000, 0x1005, 0x1002}));
+    ASSERT_EQ(blocks[2].instructions.size(), 2);
+    ASSERT_FALSE(discovery.IsTruncated());
+
+    // The stop address is never entered
+    Discovery::StaticDiscovery stopped(cache, read_code, 100);
+    stopped.AddStopAddress(0x1005);
+    ASSERT_EQ(GetAddresses(stopped.Run(kBase)), (std::vector<uint64_t>{0x1000, 0x1002}));
+
+    Discovery::StaticDiscovery limited(cache, read_code, 1);
+    ASSERT_EQ(limited.Run(kBase).size(), 1);
+    ASSERT_TRUE(limited.IsTruncated());
+}
+
+TEST_F(DiscoveryTest, TestLinearSweep) {
+    // The code, then
+    // 0x1006: int3 padding
+    // 0x1008: nop
+    // 0x1009: ret
+    auto swept = code;
+    swept.insert(swept.end(), {0xcc, 0xcc, 0x90, 0xc3});
+    const std::vector<Discovery::CodeRegion> regions = {{kBase, swept}};
+
+    // Tiny shards so targets and blocks cross shard boundaries
+    DecodeCache cache;
+    Discovery::LinearSweep sweep(cache, 4, 4);
+    sweep.Run(regions);
+
+    const auto& starts = sweep.GetBlockStarts();
+    ASSERT_EQ(starts.GetBlockStarts(), (std::vector<uint64_t>{0x1000, 0x1002, 0x1005, 0x1008}));
+    ASSERT_TRUE(starts.Test(0x1008));
+    ASSERT_FALSE(starts.Test(0x1007));
+    ASSERT_FALSE(starts.Test(0x2000));
+    ASSERT_EQ(sweep.GetBlocksDecoded(), 4);
+
+    DecodedInstruction inst;
+    ASSERT_TRUE(cache.Lookup(0x1002, inst));
+    ASSERT_EQ(inst.length, 1);
+    ASSERT_TRUE(cache.Lookup(0x1009, inst));
+    ASSERT_TRUE(inst.IsRet());
+}
+
+TEST_F(DiscoveryTest, TestLinearSweepAlignsShards) {
+    // 0x1000: mov eax, 0x2eb
+    // 0x1005: nop
+    // 0x1006: ret
+    // Decoded from 0x1001 the immediate reads as jmp 0x1005
+    const std::vector<uint8_t> mov_code = {0xb8, 0xeb, 0x02, 0x00, 0x00, 0x90, 0xc3};
+    const std::vector<Discovery::CodeRegion> regions = {{0x1000, mov_code}};
+
+    // One byte shards, all but the first start inside the mov
+    DecodeCache cache;
+    Discovery::LinearSweep sweep(cache, 4, 1);
+    sweep.Run(regions);
+
+    ASSERT_EQ(sweep.GetBlockStarts().GetBlockStarts(), (std::vector<uint64_t>{0x1000}));
+    ASSERT_EQ(sweep.GetBoundaryCount(), 3);
+    ASSERT_EQ(sweep.GetCandidateCount(), 1);
+    DecodedInstruction inst;
+    ASSERT_FALSE(cache.Lookup(0x1001, inst));
+    ASSERT_TRUE(cache.Lookup(0x1006, inst));
+    ASSERT_TRUE(inst.IsRet());
+}
+
+TEST_F(DiscoveryTest, TestRelativeJumpTable) {
+    const uint64_t image_base = 0x140000000;
+
+    // cmp ecx, 5; ja default; movsxd rax, ecx; lea rdx, [__ImageBase]
+    // mov ecx, [rdx+rax*4+0x3000]; add rcx, rdx; jmp rcx
+    Window window;
+    auto& cmp = window.Add(Kind::Cmp, {kRcx});
+    cmp.has_immediate = true;
+    cmp.immediate = 5;
+    window.Add(Kind::JumpAbove, {}, DecodedInstruction::kBranch | DecodedInstruction::kCondBranch | DecodedInstruction::kHasTarget);
+    window.Add(Kind::MovSignExtend, {kRax, kRcx});
+    auto& lea = window.Add(Kind::Lea, {kRdx});
+    lea.has_memory = true;
+    lea.displacement = image_base;
+    auto& load = window.Add(Kind::Mov, {kRcx});
+    load.has_memory = true;
+    load.base = kRdx;
+    load.index = kRax;
+    load.scale = 4;
+    load.memory_size = 4;
+    load.displacement = 0x3000;
+    window.Add(Kind::Add, {kRcx, kRdx});
+    window.Add(Kind::Jump, {kRcx}, DecodedInstruction::kBranch);
+
+    Discovery::JumpTable table;
+    ASSERT_TRUE(Discovery::RecognizeJumpTable(window.instructions, window.operands, table));
+    ASSERT_EQ(table.table_address, image_base + 0x3000);
+    ASSERT_EQ(table.entry_size, 4);
+    ASSERT_EQ(table.entry_base, image_base);
+    ASSERT_EQ(table.entry_count, 6);
+
+    // Repeated cases share a target, entries outside code are dropped
+    const std::vector<uint32_t> entries = {0x1000, 0x1010, 0x1000, 0x1020, 0x9999, 0x1030};
+    const auto read_data = [&](uint64_t address, uint8_t* buffer, size_t size) {
+        if (address != image_base + 0x3000 || size != entries.size() * 4) {
+            return false;
+        }
+        std::memcpy(buffer, entries.data(), size);
+        return true;
+    };
+    const auto is_code = [&](uint64_t target) { return target - image_base < 0x2000; };
+    ASSERT_TRUE(Discovery::ReadJumpTable(table, read_data, is_code));
+    ASSERT_EQ(table.targets, (std::vector<uint64_t>{image_base + 0x1000, image_base + 0x1010,
+                                                    image_base + 0x1020, image_base + 0x1030}));
+
+    // Without the bounds check the table size is unknown
+    window.instructions.erase(window.instructions.begin(), window.instructions.begin() + 2);
+    window.operands.erase(window.operands.begin(), window.operands.begin() + 2);
+    ASSERT_FALSE(Discovery::RecognizeJumpTable(window.instructions, window.operands, table));
+}
+
+TEST_F(DiscoveryTest, TestAbsoluteJumpTable) {
+    // cmp eax, 2; jae default; jmp [rax*8+0x5000]
+    Window window;
+    auto& cmp = window.Add(Kind::Cmp, {kRax});
+    cmp.has_immediate = true;
+    cmp.immediate = 2;
+    window.Add(Kind::JumpAboveOrEqual, {}, DecodedInstruction::kBranch | DecodedInstruction::kCondBranch | DecodedInstruction::kHasTarget);
+    auto& jump = window.Add(Kind::Jump, {}, DecodedInstruction::kBranch);
+    jump.has_memory = true;
+    jump.index = kRax;
+    jump.scale = 8;
+    jump.memory_size = 8;
+    jump.displacement = 0x5000;
+
+    Discovery::JumpTable table;
+    ASSERT_TRUE(Discovery::RecognizeJumpTable(window.instructions, window.operands, table));
+    ASSERT_EQ(table.table_address, 0x5000);
+    ASSERT_EQ(table.entry_size, 8);
+    ASSERT_EQ(table.entry_base, 0);
+    ASSERT_EQ(table.entry_count, 2);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "Lift/DiskLiftCache.h"
+#include <glog/logging.h>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+class DiskLiftCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = ::testing::TempDir() + "recycle_lift_cache_test";
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    // A module holding one lifted-looking function
+    static std::unique_ptr<llvm::Module> MakeModule(llvm::LLVMContext& context, const std::string& name) {
+        auto module = std::make_unique<llvm::Module>("lifted_code", context);
+        auto* type = llvm::FunctionType::get(llvm::Type::getInt64Ty(context), false);
+        auto* function = llvm::Function::Create(type, llvm::GlobalValue::ExternalLinkage, name, module.get());
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", function));
+        builder.CreateRet(builder.getInt64(42));
+        return module;
+    }
+
+    static std::vector<DecodedInstruction> MakeInstructions(uint64_t address, uint8_t opcode) {
+        DecodedInstruction inst;
+        inst.address = address;
+        inst.length = 1;
+        inst.bytes[0] = opcode;
+        return {inst};
+    }
+
+    std::string directory;
+};
+
+TEST_F(DiskLiftCacheTest, TestKeyCoversAddressAndBytes) {
+    const auto key = DiskLiftCache::GetKey("windows/amd64", "semantics", 0x1000, MakeInstructions(0x1000, 0x90));
+    ASSERT_EQ(key.size(), 40);
+    ASSERT_EQ(key, DiskLiftCache::GetKey("windows/amd64", "semantics", 0x1000, MakeInstructions(0x1000, 0x90)));
+    ASSERT_NE(key, DiskLiftCache::GetKey("windows/amd64", "semantics", 0x2000, MakeInstructions(0x2000, 0x90)));
+    ASSERT_NE(key, DiskLiftCache::GetKey("windows/amd64", "semantics", 0x1000, MakeInstructions(0x1000, 0xc3)));
+    ASSERT_NE(key, DiskLiftCache::GetKey("linux/amd64", "semantics", 0x1000, MakeInstructions(0x1000, 0x90)));
+    ASSERT_NE(key, DiskLiftCache::GetKey("windows/amd64", "rebuilt", 0x1000, MakeInstructions(0x1000, 0x90)));
+}
+
+TEST_F(DiskLiftCacheTest, TestSemanticsHashFollowsTheModule) {
+    llvm::LLVMContext context;
+    const auto hash = DiskLiftCache::HashModule(*MakeModule(context, "sem_add"));
+    ASSERT_EQ(hash.size(), 40);
+    ASSERT_EQ(hash, DiskLiftCache::HashModule(*MakeModule(context, "sem_add")));
+    ASSERT_NE(hash, DiskLiftCache::HashModule(*MakeModule(context, "sem_sub")));
+}
+
+TEST_F(DiskLiftCacheTest, TestOnlyStaleTempFilesAreRemoved) {
+    std::filesystem::create_directories(directory);
+    const auto stale = std::filesystem::path(directory) / "a.1.0.tmp";
+    const auto writing = std::filesystem::path(directory) / "b.2.0.tmp";
+    std::ofstream(stale) << "partial";
+    std::ofstream(writing) << "partial";
+    std::filesystem::last_write_time(stale, std::filesystem::file_time_type::clock::now() - std::chrono::hours(2));
+
+    // The fresh one may still be renamed into place by another session
+    DiskLiftCache cache(directory, 1 << 20);
+    ASSERT_TRUE(cache.Open());
+    ASSERT_FALSE(std::filesystem::exists(stale));
+    ASSERT_TRUE(std::filesystem::exists(writing));
+    ASSERT_EQ(cache.GetEntryCount(), 0);
+}
+
+TEST_F(DiskLiftCacheTest, TestRoundTripAcrossSessions) {
+    const auto key = DiskLiftCache::GetKey("windows/amd64", "semantics", 0x1000, MakeInstructions(0x1000, 0x90));
+    {
+        DiskLiftCache cache(directory, 1 << 20);
+        ASSERT_TRUE(cache.Open());
+        llvm::LLVMContext context;
+        ASSERT_EQ(cache.Load(key, context), nullptr);
+        ASSERT_TRUE(cache.Store(key, *MakeModule(context, "sub_1000")));
+        ASSERT_EQ(cache.GetStores(), 1);
+        ASSERT_EQ(cache.GetMisses(), 1);
+    }
+
+    // A new session finds the entry and parses it into its own context
+    DiskLiftCache cache(directory, 1 << 20);
+    ASSERT_TRUE(cache.Open());
+    ASSERT_EQ(cache.GetEntryCount(), 1);
+    llvm::LLVMContext context;
+    auto module = cache.Load(key, context);
+    ASSERT_NE(module, nullptr);
+    ASSERT_EQ(&module->getContext(), &context);
+    const auto* function = module->getFunction("sub_1000");
+    ASSERT_NE(function, nullptr);
+    ASSERT_FALSE(function->isDeclaration());
+    ASSERT_EQ(cache.GetHits(), 1);
+    ASSERT_DOUBLE_EQ(cache.GetHitRate(), 1.0);
+}
+
+TEST_F(DiskLiftCacheTest, TestFindsEntriesOfConcurrentSessions) {
+    const auto key = DiskLiftCache::GetKey("windows/amd64", "semantics", 0x1000, MakeInstructions(0x1000, 0x90));
+    DiskLiftCache first(directory, 1 << 20);
+    DiskLiftCache second(directory, 1 << 20);
+    ASSERT_TRUE(first.Open());
+    ASSERT_TRUE(second.Open());
+
+    // Stored after the second session indexed the directory
+    llvm::LLVMContext context;
+    ASSERT_TRUE(first.Store(key, *MakeModule(context, "sub_1000")));
+    ASSERT_NE(second.Load(key, context), nullptr);
+    ASSERT_EQ(second.GetHits(), 1);
+    ASSERT_EQ(second.GetEntryCount(), 1);
+    ASSERT_EQ(second.GetSize(), first.GetSize());
+}
+
+TEST_F(DiskLiftCacheTest, TestEvictsLeastRecentlyUsed) {
+    llvm::LLVMContext context;
+    const auto module = MakeModule(context, "sub_1000");
+
+    // Measure one entry, then allow two
+    uint64_t entry_size = 0;
+    {
+        DiskLiftCache probe(directory + "_probe", 1 << 20);
+        ASSERT_TRUE(probe.Open());
+        ASSERT_TRUE(probe.Store("probe", *module));
+        entry_size = probe.GetSize();
+        std::filesystem::remove_all(directory + "_probe");
+    }
+    ASSERT_GT(entry_size, 0);
+
+    DiskLiftCache cache(directory, 2 * entry_size);
+    ASSERT_TRUE(cache.Open());
+    ASSERT_TRUE(cache.Store("a", *module));
+    ASSERT_TRUE(cache.Store("b", *module));
+    ASSERT_NE(cache.Load("a", context), nullptr);
+    ASSERT_TRUE(cache.Store("c", *module));
+
+    // b was used longest ago
+    ASSERT_EQ(cache.GetEvictions(), 1);
+    ASSERT_EQ(cache.GetEntryCount(), 2);
+    ASSERT_LE(cache.GetSize(), 2 * entry_size);
+    ASSERT_NE(cache.Load("a", context), nullptr);
+    ASSERT_EQ(cache.Load("b", context), nullptr);
+    ASSERT_NE(cache.Load("c", context), nullptr);
+}
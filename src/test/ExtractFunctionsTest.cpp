@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "BitcodeManipulation/ExtractFunctions.h"
+
+class ExtractFunctionsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        source = llvm::parseAssemblyString(kSemantics, error, context);
+        ASSERT_NE(source, nullptr) << error.getMessage().str();
+    }
+
+    // Stand-in for the remill semantics with one lifted function added to it
+    static constexpr const char* kSemantics = R"(
+@table = internal constant [2 x i32] [i32 1, i32 2]
+@isel_unused = constant void (i32*)* @sem_unused
+@isel_add = constant i32 (i32, i32)* @sem_add
+
+declare void @__remill_missing_block(i32)
+
+define internal i32 @helper(i32 %a) {
+  %p = getelementptr [2 x i32], [2 x i32]* @table, i32 0, i32 1
+  %v = load i32, i32* %p
+  %r = add i32 %a, %v
+  ret i32 %r
+}
+
+define i32 @sem_add(i32 %a, i32 %b) {
+  %h = call i32 @helper(i32 %a)
+  %r = add i32 %h, %b
+  ret i32 %r
+}
+
+define void @sem_unused(i32* %p) {
+  store i32 0, i32* %p
+  ret void
+}
+
+define i32 @sub_1000(i32 %a) {
+  %r = call i32 @sem_add(i32 %a, i32 1)
+  call void @__remill_missing_block(i32 %r)
+  ret i32 %r
+}
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 1, !"wchar_size", i32 4}
+)";
+
+    llvm::LLVMContext context;
+    llvm::SMDiagnostic error;
+    std::unique_ptr<llvm::Module> source;
+};
+
+TEST_F(ExtractFunctionsTest, TestOnlyReachableGlobalsAreCopied) {
+    const size_t source_functions = source->size();
+
+    auto* lifted = source->getFunction("sub_1000");
+    auto extracted = BitcodeManipulation::ExtractFunctions(*source, {lifted});
+    ASSERT_NE(extracted, nullptr);
+    ASSERT_FALSE(llvm::verifyModule(*extracted, &llvm::errs()));
+
+    // The lifted function and everything it calls, with bodies
+    for (const char* name : {"sub_1000", "sem_add", "helper"}) {
+        const auto* function = extracted->getFunction(name);
+        ASSERT_NE(function, nullptr) << name;
+        ASSERT_FALSE(function->isDeclaration()) << name;
+    }
+    ASSERT_TRUE(extracted->getFunction("__remill_missing_block")->isDeclaration());
+    ASSERT_NE(extracted->getGlobalVariable("table", true), nullptr);
+
+    // Nothing unreachable, not even as a declaration
+    ASSERT_EQ(extracted->getFunction("sem_unused"), nullptr);
+    ASSERT_EQ(extracted->getGlobalVariable("isel_unused"), nullptr);
+    ASSERT_EQ(extracted->getGlobalVariable("isel_add"), nullptr);
+    ASSERT_EQ(extracted->size(), 4);
+    ASSERT_NE(extracted->getModuleFlag("wchar_size"), nullptr);
+
+    // The source is untouched
+    ASSERT_EQ(source->size(), source_functions);
+    ASSERT_EQ(source->getFunction("sub_1000"), lifted);
+    ASSERT_FALSE(lifted->isDeclaration());
+}
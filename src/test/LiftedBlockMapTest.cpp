@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "Lift/LiftedBlockMap.h"
+#include <glog/logging.h>
+
+class LiftedBlockMapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        map.Add(0x1000, MakeBlock(0x1000, {2, 3, 1}));
+    }
+
+    // Block of consecutive instructions with the given lengths
+    static std::vector<DecodedInstruction> MakeBlock(uint64_t address, std::vector<uint8_t> lengths) {
+        std::vector<DecodedInstruction> instructions;
+        for (const auto length : lengths) {
+            DecodedInstruction inst;
+            inst.address = address;
+            inst.length = length;
+            instructions.push_back(inst);
+            address += length;
+        }
+        return instructions;
+    }
+
+    // Starts with one block of three instructions at 0x1000..0x1006
+    LiftedBlockMap map;
+    LiftedBlockMap::Block head, tail;
+};
+
+TEST_F(LiftedBlockMapTest, TestFindContaining) {
+    map.Add(0x2000, MakeBlock(0x2000, {4}));
+
+    ASSERT_EQ(map.FindContaining(0x1000)->address, 0x1000);
+    ASSERT_EQ(map.FindContaining(0x1005)->address, 0x1000);
+    ASSERT_EQ(map.FindContaining(0x1006), nullptr);
+    ASSERT_EQ(map.FindContaining(0xfff), nullptr);
+    ASSERT_EQ(map.FindContaining(0x2003)->address, 0x2000);
+}
+
+TEST_F(LiftedBlockMapTest, TestSplit) {
+    // Inside an instruction, the target has to be lifted on its own
+    ASSERT_FALSE(map.Split(0x1003, head, tail));
+    ASSERT_FALSE(map.Split(0x1006, head, tail));
+
+    ASSERT_TRUE(map.Split(0x1002, head, tail));
+    ASSERT_EQ(head.address, 0x1000);
+    ASSERT_EQ(head.instructions.size(), 1);
+    ASSERT_EQ(head.GetEnd(), 0x1002);
+    ASSERT_EQ(tail.address, 0x1002);
+    ASSERT_EQ(tail.instructions.size(), 2);
+    ASSERT_EQ(tail.GetEnd(), 0x1006);
+
+    ASSERT_EQ(map.GetBlockCount(), 2);
+    ASSERT_EQ(map.GetSplitCount(), 1);
+    ASSERT_EQ(map.FindContaining(0x1004)->address, 0x1002);
+    ASSERT_EQ(map.GetBlock(0x1000)->GetEnd(), 0x1002);
+}
+
+TEST_F(LiftedBlockMapTest, TestSplitAtExistingBlock) {
+    // A branch target decoded on its own and also reached by falling through
+    map.Add(0x1005, MakeBlock(0x1005, {1, 4}));
+
+    ASSERT_TRUE(map.Split(0x1005, head, tail));
+    ASSERT_EQ(head.GetEnd(), 0x1005);
+    ASSERT_EQ(tail.instructions.size(), 2);
+    ASSERT_EQ(map.GetBlockCount(), 2);
+}
+
+TEST_F(LiftedBlockMapTest, TestNextStartAfter) {
+    map.Add(0x2000, MakeBlock(0x2000, {4}));
+
+    ASSERT_EQ(map.NextStartAfter(0xfff), 0x1000);
+    ASSERT_EQ(map.NextStartAfter(0x1000), 0x2000);
+    ASSERT_EQ(map.NextStartAfter(0x1800), 0x2000);
+    ASSERT_EQ(map.NextStartAfter(0x2000), UINT64_MAX);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "Minidump/MemoryRegionIndex.h"
+#include <glog/logging.h>
+
+class MemoryRegionIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Three regions: two adjacent ones followed by a gap
+        first.assign(0x1000, 0x11);
+        second.assign(0x1000, 0x22);
+        third.assign(0x800, 0x33);
+
+        // Insert out of order to make sure Build sorts them
+        index.Build({
+            {0x5000, third.size(), third.data(), 0x02},
+            {0x1000, first.size(), first.data(), 0x20},
+            {0x2000, second.size(), second.data(), 0x04},
+            {0x9000, 0, nullptr, 0x01},
+        });
+    }
+
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+    std::vector<uint8_t> third;
+    MinidumpContext::MemoryRegionIndex index;
+};
+
+TEST_F(MemoryRegionIndexTest, TestFind) {
+    // Empty region is dropped
+    ASSERT_EQ(index.GetRegionCount(), 3);
+
+    ASSERT_EQ(index.Find(0xfff), nullptr);
+    ASSERT_EQ(index.Find(0x1000)->base, 0x1000);
+    ASSERT_EQ(index.Find(0x1fff)->base, 0x1000);
+    ASSERT_EQ(index.Find(0x2000)->protect, 0x04);
+    ASSERT_EQ(index.Find(0x3000), nullptr);
+    ASSERT_EQ(index.Find(0x57ff)->base, 0x5000);
+    ASSERT_EQ(index.Find(0x5800), nullptr);
+    ASSERT_EQ(index.Find(0x9000), nullptr);
+}
+
+TEST_F(MemoryRegionIndexTest, TestViewIsTruncatedAtRegionEnd) {
+    auto view = index.View(0x1ff0, 0x100);
+    ASSERT_EQ(view.size(), 0x10);
+    ASSERT_EQ(view.data(), first.data() + 0xff0);
+
+    ASSERT_TRUE(index.View(0x3000, 0x10).empty());
+}
+
+TEST_F(MemoryRegionIndexTest, TestReadSpansAdjacentRegions) {
+    std::vector<uint8_t> out(0x20);
+    ASSERT_EQ(index.Read(0x1ff0, out.data(), out.size()), 0x20);
+    ASSERT_EQ(out[0x0f], 0x11);
+    ASSERT_EQ(out[0x10], 0x22);
+
+    // Read stops at the gap after the second region
+    out.resize(0x100);
+    ASSERT_EQ(index.Read(0x2f80, out.data(), out.size()), 0x80);
+
+    ASSERT_EQ(index.Read(0x4000, out.data(), out.size()), 0);
+}
+
+TEST_F(MemoryRegionIndexTest, TestReadRanges) {
+    std::vector<uint8_t> out(4 * 0x800);
+    std::vector<MinidumpContext::MemoryRange> ranges = {
+        {0x1800, 0x800, out.data(), 0},             // Tail of the first region
+        {0x2000, 0x800, out.data() + 0x800, 0},     // Back-to-back, next region
+        {0x2c00, 0x800, out.data() + 0x1000, 0},    // Runs into the gap
+        {0x5000, 0x800, out.data() + 0x1800, 0},    // Separate region
+    };
+
+    ASSERT_EQ(index.ReadRanges(ranges), 3);
+    ASSERT_EQ(ranges[0].bytes_read, 0x800);
+    ASSERT_EQ(ranges[1].bytes_read, 0x800);
+    ASSERT_EQ(ranges[2].bytes_read, 0x400);
+    ASSERT_EQ(ranges[3].bytes_read, 0x800);
+    ASSERT_EQ(out[0x7ff], 0x11);
+    ASSERT_EQ(out[0x800], 0x22);
+    ASSERT_EQ(out[0x1800], 0x33);
+}
+
+TEST_F(MemoryRegionIndexTest, TestNextRegionBase) {
+    ASSERT_EQ(index.NextRegionBase(0), 0x1000);
+    ASSERT_EQ(index.NextRegionBase(0x1000), 0x2000);
+    ASSERT_EQ(index.NextRegionBase(0x3000), 0x5000);
+    ASSERT_EQ(index.NextRegionBase(0x5800), UINT64_MAX);
+}
@@ -92,4 +92,57 @@ TEST_F(MissingMemoryTrackerTest, TestPageBoundaryTouch) {
     ASSERT_EQ(missing_memory[1].first, BASE_PAGE + PAGE_SIZE);
     ASSERT_EQ(missing_memory[1].second, TOUCH_SIZE);
     LOG(INFO) << "Verified second page at 0x" << std::hex << missing_memory[1].first;
-} 
\ No newline at end of file
+} 
+
+TEST_F(MissingMemoryTrackerTest, TestReadAheadGrowsOnSequentialMisses) {
+    const uint64_t PAGE_SIZE = PREBUILT_MEMORY_CELL_SIZE;
+    Runtime::MemoryReadAhead read_ahead(8);
+
+    // First miss prefetches a single neighbour
+    auto pages = read_ahead.OnMiss(0x10000);
+    ASSERT_EQ(pages.size(), 1);
+    ASSERT_EQ(pages[0], 0x10000 + PAGE_SIZE);
+    read_ahead.AddPrefetched(pages[0]);
+    read_ahead.OnExecuted({0x10000, 0x10000 + PAGE_SIZE});
+
+    // Missing right after the prefetched page doubles the window
+    pages = read_ahead.OnMiss(0x10000 + 2 * PAGE_SIZE);
+    ASSERT_EQ(pages.size(), 2);
+    ASSERT_EQ(pages[0], 0x10000 + 3 * PAGE_SIZE);
+    ASSERT_EQ(pages[1], 0x10000 + 4 * PAGE_SIZE);
+    ASSERT_EQ(read_ahead.GetHits(), 1);
+    ASSERT_EQ(read_ahead.GetWasted(), 0);
+}
+
+TEST_F(MissingMemoryTrackerTest, TestReadAheadShrinksOnWaste) {
+    const uint64_t PAGE_SIZE = PREBUILT_MEMORY_CELL_SIZE;
+    Runtime::MemoryReadAhead read_ahead(8);
+
+    // Sequential misses with every prefetched page read grow the window to 4
+    uint64_t next_miss = 0x10000;
+    for (int i = 0; i < 3; i++) {
+        std::unordered_set<uint64_t> accessed = {next_miss};
+        for (const auto page_addr : read_ahead.OnMiss(next_miss)) {
+            read_ahead.AddPrefetched(page_addr);
+            accessed.insert(page_addr);
+            next_miss = page_addr + PAGE_SIZE;
+        }
+        if (i < 2) {
+            read_ahead.OnExecuted(accessed);
+        }
+    }
+    ASSERT_EQ(read_ahead.GetWindow(), 4);
+    ASSERT_EQ(read_ahead.GetHits(), 3);
+
+    // None of the last four were read, the window halves
+    read_ahead.OnExecuted({});
+    ASSERT_EQ(read_ahead.GetWasted(), 4);
+    ASSERT_EQ(read_ahead.GetWindow(), 2);
+}
+
+TEST_F(MissingMemoryTrackerTest, TestReadAheadDisabled) {
+    Runtime::MemoryReadAhead read_ahead(0);
+    ASSERT_TRUE(read_ahead.OnMiss(0x10000).empty());
+    ASSERT_TRUE(read_ahead.OnMiss(0x11000).empty());
+    ASSERT_EQ(read_ahead.GetWindow(), 0);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "Minidump/PEImage.h"
+#include <glog/logging.h>
+
+#include <cstring>
+
+class PEImageTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Minimal PE32+ header page: .text, .rdata and .data, IAT in .rdata
+        image.assign(0x1000, 0);
+        Store<uint16_t>(0, 0x5a4d);
+        Store<uint32_t>(0x3c, 0x80);
+        Store<uint32_t>(0x80, 0x00004550);
+
+        const size_t file_header = 0x84;
+        Store<uint16_t>(file_header + 2, 3);            // NumberOfSections
+        Store<uint16_t>(file_header + 16, 0xf0);        // SizeOfOptionalHeader
+        const size_t optional_header = file_header + 20;
+        Store<uint16_t>(optional_header, 0x20b);
+        Store<uint32_t>(optional_header + 108, 16);     // NumberOfRvaAndSizes
+        Store<uint32_t>(optional_header + 112 + 12 * 8, 0x3000);
+        Store<uint32_t>(optional_header + 112 + 12 * 8 + 4, 0x80);
+
+        const size_t section_table = optional_header + 0xf0;
+        AddSection(section_table, ".text", 0x1800, 0x1000, 0x60000020);
+        AddSection(section_table + 40, ".rdata", 0x900, 0x3000, 0x40000040);
+        AddSection(section_table + 80, ".data", 0x200, 0x4000, 0xc0000040);
+    }
+
+    template <typename T>
+    void Store(size_t offset, T value) {
+        std::memcpy(image.data() + offset, &value, sizeof(T));
+    }
+
+    void AddSection(size_t offset, const char* name, uint32_t virtual_size, uint32_t rva, uint32_t characteristics) {
+        std::memcpy(image.data() + offset, name, strlen(name));
+        Store<uint32_t>(offset + 8, virtual_size);
+        Store<uint32_t>(offset + 12, rva);
+        Store<uint32_t>(offset + 36, characteristics);
+    }
+
+    size_t Read(uint64_t address, uint8_t* out, size_t size) const {
+        if (address < kBase || address - kBase >= image.size()) {
+            return 0;
+        }
+        const size_t available = std::min<size_t>(size, image.size() - (address - kBase));
+        std::memcpy(out, image.data() + (address - kBase), available);
+        return available;
+    }
+
+    static constexpr uint64_t kBase = 0x140000000;
+    std::vector<uint8_t> image;
+};
+
+TEST_F(PEImageTest, TestParseSections) {
+    MinidumpContext::ModuleInfo module = {kBase, 0x5000, "test.exe"};
+    ASSERT_TRUE(MinidumpContext::ParsePEImage(module, [this](uint64_t address, uint8_t* out, size_t size) {
+        return Read(address, out, size);
+    }));
+
+    ASSERT_EQ(module.sections.size(), 3);
+    ASSERT_EQ(module.sections[0].name, ".text");
+    ASSERT_EQ(module.sections[0].address, kBase + 0x1000);
+    ASSERT_EQ(module.sections[0].size, 0x1800);
+    ASSERT_TRUE(module.sections[0].IsExecutable());
+    ASSERT_EQ(module.sections[1].name, ".rdata");
+    ASSERT_FALSE(module.sections[1].IsWritable());
+    ASSERT_TRUE(module.sections[2].IsWritable());
+    ASSERT_EQ(module.iat_address, kBase + 0x3000);
+    ASSERT_EQ(module.iat_size, 0x80);
+
+    ASSERT_EQ(MinidumpContext::FindSection(module, kBase + 0x27ff)->name, ".text");
+    ASSERT_EQ(MinidumpContext::FindSection(module, kBase + 0x2800), nullptr);
+    ASSERT_EQ(MinidumpContext::FindSection(module, kBase + 0x3100)->name, ".rdata");
+}
+
+TEST_F(PEImageTest, TestSectionDecidesImmutability) {
+    MinidumpContext::ModuleInfo module = {kBase, 0x5000, "test.exe"};
+    ASSERT_TRUE(MinidumpContext::ParsePEImage(module, [this](uint64_t address, uint8_t* out, size_t size) {
+        return Read(address, out, size);
+    }));
+
+    // Region without protection info, the section table decides
+    MinidumpContext::MemoryInfo info;
+    info.mapped = true;
+    info.module = &module;
+    info.section = MinidumpContext::FindSection(module, kBase + 0x3000);
+    ASSERT_TRUE(info.IsImmutable());
+    info.section = MinidumpContext::FindSection(module, kBase + 0x4000);
+    ASSERT_FALSE(info.IsImmutable());
+
+    // Writable pages are never immutable
+    info.section = MinidumpContext::FindSection(module, kBase + 0x3000);
+    info.protect = MinidumpContext::kPageReadWrite;
+    ASSERT_FALSE(info.IsImmutable());
+}
+
+TEST_F(PEImageTest, TestRejectsMissingHeaders) {
+    image[0] = 0;
+    MinidumpContext::ModuleInfo module = {kBase, 0x5000, "test.exe"};
+    ASSERT_FALSE(MinidumpContext::ParsePEImage(module, [this](uint64_t address, uint8_t* out, size_t size) {
+        return Read(address, out, size);
+    }));
+    ASSERT_TRUE(module.sections.empty());
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "Snapshot/Snapshot.h"
+#include <glog/logging.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "recycle_snapshot_test.snap";
+
+        // Two identical pages to check deduplication, then an adjacent unique page
+        code.assign(3 * PREBUILT_MEMORY_CELL_SIZE, 0xcc);
+        for (size_t i = 2 * PREBUILT_MEMORY_CELL_SIZE; i < code.size(); i++) {
+            code[i] = static_cast<uint8_t>(i);
+        }
+        data.assign(PREBUILT_MEMORY_CELL_SIZE, 0x42);
+
+        regions.Build({
+            {0x140001000, code.size(), code.data(), MinidumpContext::kPageExecuteRead, MinidumpContext::kMemImage},
+            {0x7ff000000, data.size(), data.data(), MinidumpContext::kPageReadWrite, 0},
+        });
+        modules = {{0x140000000, 0x10000, "test.exe"}};
+        ASSERT_TRUE(Snapshot::WriteSnapshot(path, regions, modules, 0x140001234, 0x7ff000000));
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    std::string path;
+    std::vector<uint8_t> code;
+    std::vector<uint8_t> data;
+    MinidumpContext::MemoryRegionIndex regions;
+    std::vector<MinidumpContext::ModuleInfo> modules;
+};
+
+TEST_F(SnapshotTest, TestRoundTrip) {
+    Snapshot::SnapshotFile snapshot;
+    ASSERT_TRUE(snapshot.Open(path));
+
+    ASSERT_EQ(snapshot.GetInstructionPointer(), 0x140001234);
+    ASSERT_EQ(snapshot.GetThreadTebAddress(), 0x7ff000000);
+    ASSERT_EQ(snapshot.GetPages().size(), 4);
+    ASSERT_EQ(snapshot.GetRegions().size(), 2);
+
+    // The first two code pages share their data
+    ASSERT_EQ(snapshot.GetPages()[0].data_index, snapshot.GetPages()[1].data_index);
+    ASSERT_EQ(snapshot.GetPages()[0].protect, MinidumpContext::kPageExecuteRead);
+
+    auto memory = snapshot.ReadMemory(0x140001000, code.size());
+    ASSERT_EQ(memory, code);
+
+    ASSERT_EQ(snapshot.ReadMemoryView(0x7ff000010, 0x10)[0], 0x42);
+    ASSERT_TRUE(snapshot.ReadMemoryView(0x7ff001000, 0x10).empty());
+    ASSERT_EQ(snapshot.FindPage(0x140000fff), nullptr);
+}
+
+TEST_F(SnapshotTest, TestViewCrossesContiguousPages) {
+    Snapshot::SnapshotFile snapshot;
+    ASSERT_TRUE(snapshot.Open(path));
+
+    // The second and third code pages are stored back to back
+    auto view = snapshot.ReadMemoryView(0x140002ff0, 0x20);
+    ASSERT_EQ(view.size(), 0x20);
+    ASSERT_EQ(view[0x10], code[2 * PREBUILT_MEMORY_CELL_SIZE]);
+}
+
+TEST_F(SnapshotTest, TestQueryMemory) {
+    Snapshot::SnapshotFile snapshot;
+    ASSERT_TRUE(snapshot.Open(path));
+
+    auto code_info = snapshot.QueryMemory(0x140002000);
+    ASSERT_TRUE(code_info.mapped);
+    ASSERT_TRUE(code_info.IsExecutable());
+    ASSERT_TRUE(code_info.IsImmutable());
+    ASSERT_NE(code_info.module, nullptr);
+    ASSERT_EQ(code_info.module->name, "test.exe");
+
+    auto data_info = snapshot.QueryMemory(0x7ff000800);
+    ASSERT_TRUE(data_info.IsNonExecutable());
+    ASSERT_FALSE(data_info.IsImmutable());
+    ASSERT_EQ(data_info.module, nullptr);
+
+    ASSERT_FALSE(snapshot.QueryMemory(0x1000).mapped);
+}
+
+TEST_F(SnapshotTest, TestRejectsTruncatedFile) {
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - PREBUILT_MEMORY_CELL_SIZE);
+
+    Snapshot::SnapshotFile snapshot;
+    ASSERT_FALSE(snapshot.Open(path));
+}
+
+TEST_F(SnapshotTest, TestRejectsCorruptPageEntry) {
+    // Point the first page past the stored data
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    Snapshot::SnapshotHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    Snapshot::SnapshotPageEntry page = {};
+    file.seekg(header.page_table_offset);
+    file.read(reinterpret_cast<char*>(&page), sizeof(page));
+    page.data_index = static_cast<uint32_t>(header.data_page_count);
+    file.seekp(header.page_table_offset);
+    file.write(reinterpret_cast<const char*>(&page), sizeof(page));
+    file.close();
+
+    Snapshot::SnapshotFile snapshot;
+    ASSERT_FALSE(snapshot.Open(path));
+}
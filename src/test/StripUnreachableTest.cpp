@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "BitcodeManipulation/StripUnreachable.h"
+
+class StripUnreachableTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        module = llvm::parseAssemblyString(kMerged, error, context);
+        ASSERT_NE(module, nullptr) << error.getMessage().str();
+    }
+
+    // Stand-in for a merged module: two lifted blocks, the semantics they call,
+    // semantics and runtime helpers nothing calls, and the entry point
+    static constexpr const char* kMerged = R"(
+@table = internal constant [2 x i32] [i32 1, i32 2]
+@unused_table = internal constant [2 x i32] [i32 3, i32 4]
+@isel_unused = constant void (i32*)* @sem_unused
+@Accessed = global i32 0
+@llvm.used = appending global [1 x i8*] [i8* bitcast (i32 (i32)* @kept_by_used to i8*)], section "llvm.metadata"
+
+declare void @__remill_missing_block(i32)
+declare void @__remill_unused_intrinsic(i32)
+
+define internal i32 @helper(i32 %a) {
+  %p = getelementptr [2 x i32], [2 x i32]* @table, i32 0, i32 1
+  %v = load i32, i32* %p
+  %r = add i32 %a, %v
+  ret i32 %r
+}
+
+define i32 @sem_add(i32 %a, i32 %b) {
+  %h = call i32 @helper(i32 %a)
+  %r = add i32 %h, %b
+  ret i32 %r
+}
+
+define void @sem_unused(i32* %p) {
+  %q = getelementptr [2 x i32], [2 x i32]* @unused_table, i32 0, i32 0
+  %v = load i32, i32* %q
+  store i32 %v, i32* %p
+  call void @__remill_unused_intrinsic(i32 %v)
+  ret void
+}
+
+define i32 @kept_by_used(i32 %a) {
+  ret i32 %a
+}
+
+define i32 @sub_1000(i32 %a) {
+  %r = call i32 @sem_add(i32 %a, i32 1)
+  call void @__remill_missing_block(i32 %r)
+  ret i32 %r
+}
+
+define i32 @sub_2000(i32 %a) {
+  ret i32 %a
+}
+
+define i32 @main() {
+  %r = call i32 @sub_1000(i32 0)
+  ret i32 %r
+}
+)";
+
+    llvm::LLVMContext context;
+    llvm::SMDiagnostic error;
+    std::unique_ptr<llvm::Module> module;
+};
+
+TEST_F(StripUnreachableTest, TestUnreachableGlobalsAreRemoved) {
+    const size_t removed = BitcodeManipulation::StripUnreachable(*module, {"main", "Accessed"});
+    ASSERT_FALSE(llvm::verifyModule(*module, &llvm::errs()));
+
+    // Roots, lifted blocks and everything they reach stay
+    for (const char* name : {"main", "sub_1000", "sub_2000", "sem_add", "helper", "kept_by_used"}) {
+        const auto* function = module->getFunction(name);
+        ASSERT_NE(function, nullptr) << name;
+        ASSERT_FALSE(function->isDeclaration()) << name;
+    }
+    ASSERT_NE(module->getFunction("__remill_missing_block"), nullptr);
+    ASSERT_NE(module->getGlobalVariable("table", true), nullptr);
+    ASSERT_NE(module->getGlobalVariable("Accessed"), nullptr);
+    ASSERT_NE(module->getGlobalVariable("llvm.used"), nullptr);
+
+    // Unused semantics, the globals only they use and unused declarations go
+    ASSERT_EQ(module->getFunction("sem_unused"), nullptr);
+    ASSERT_EQ(module->getFunction("__remill_unused_intrinsic"), nullptr);
+    ASSERT_EQ(module->getGlobalVariable("unused_table", true), nullptr);
+    ASSERT_EQ(module->getGlobalVariable("isel_unused"), nullptr);
+    ASSERT_EQ(removed, 4);
+}
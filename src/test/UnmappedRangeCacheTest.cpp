@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "Minidump/UnmappedRangeCache.h"
+#include <glog/logging.h>
+
+class UnmappedRangeCacheTest : public ::testing::Test {
+protected:
+    MinidumpContext::UnmappedRangeCache cache;
+};
+
+TEST_F(UnmappedRangeCacheTest, TestContains) {
+    ASSERT_FALSE(cache.Contains(0x1000));
+
+    cache.Add(0x1000, 0x2000);
+    ASSERT_FALSE(cache.Contains(0xfff));
+    ASSERT_TRUE(cache.Contains(0x1000));
+    ASSERT_TRUE(cache.Contains(0x2fff));
+    ASSERT_FALSE(cache.Contains(0x3000));
+
+    // Range must be covered as a whole
+    ASSERT_TRUE(cache.Contains(0x1000, 0x2000));
+    ASSERT_FALSE(cache.Contains(0x2000, 0x2000));
+}
+
+TEST_F(UnmappedRangeCacheTest, TestMerge) {
+    cache.Add(0x1000, 0x1000);
+    cache.Add(0x4000, 0x1000);
+    ASSERT_EQ(cache.GetRangeCount(), 2);
+
+    // Adjacent page joins the first range
+    cache.Add(0x2000, 0x1000);
+    ASSERT_EQ(cache.GetRangeCount(), 2);
+    ASSERT_TRUE(cache.Contains(0x1000, 0x2000));
+
+    // Filling the hole merges everything
+    cache.Add(0x2800, 0x1800);
+    ASSERT_EQ(cache.GetRangeCount(), 1);
+    ASSERT_TRUE(cache.Contains(0x1000, 0x4000));
+
+    // Range running to the end of the address space
+    cache.Add(0xfffffffffffff000, 0x1000);
+    ASSERT_TRUE(cache.Contains(0xfffffffffffff000, 0xfff));
+    ASSERT_EQ(cache.GetRangeCount(), 2);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "Disasm/BasicBlockDisassembler.h"
+#include "Disasm/XEDDisassembler.h"
+#include <glog/logging.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    // nop; nop; je +3; ret
+    const uint8_t kCode[] = {0x90, 0x90, 0x74, 0x03, 0xc3};
+    constexpr size_t kThreads = 16;
+    constexpr size_t kIterations = 2000;
+
+    bool SameInstruction(const DecodedInstruction& a, const DecodedInstruction& b) {
+        return a.address == b.address && a.length == b.length && a.flags == b.flags &&
+               a.target == b.target && a.iclass == b.iclass && a.GetBytes() == b.GetBytes();
+    }
+}
+
+TEST(XEDDisassemblerTest, TestSharedInstance) {
+    ASSERT_EQ(&XEDDisassembler::Get(), &XEDDisassembler::Get());
+}
+
+TEST(XEDDisassemblerTest, TestConcurrentDecode) {
+    std::vector<DecodedInstruction> expected;
+    for (size_t offset = 0; offset < sizeof(kCode); offset++) {
+        expected.push_back(XEDDisassembler().DecodeInstruction(kCode + offset, sizeof(kCode) - offset, 0x1000 + offset));
+    }
+
+    // The tables are set up by now, every thread decodes through the shared
+    // instance at once and must see the same results as a serial decode
+    std::atomic<bool> go{false};
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            const auto& disasm = XEDDisassembler::Get();
+            for (size_t i = 0; i < kIterations; i++) {
+                const size_t offset = (i + t) % sizeof(kCode);
+                const auto inst = disasm.DecodeInstruction(kCode + offset, sizeof(kCode) - offset, 0x1000 + offset);
+                if (!SameInstruction(inst, expected[offset])) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    go = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(XEDDisassemblerTest, TestConcurrentBlocksShareCache) {
+    DecodeCache cache;
+    BasicBlockDisassembler disassembler(32, &cache);
+
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; t++) {
+        threads.emplace_back([&] {
+            std::array<DecodedInstruction, 8> buffer;
+            for (size_t i = 0; i < kIterations; i++) {
+                const size_t count = disassembler.DisassembleBlock(kCode, sizeof(kCode), 0x1000, buffer);
+                if (count != 3 || !buffer[2].IsCondBranch() || buffer[2].target != 0x1007) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(mismatches, 0);
+    ASSERT_EQ(cache.GetSize(), 3);
+    ASSERT_EQ(cache.GetHits() + cache.GetMisses(), kThreads * kIterations * 3);
+}